@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+class Allocator;
+
+/**
+* Allocation class
+* @brief a range of a VkDeviceMemory handed out by vks::Allocator, resources bind to `Memory` at `Offset`
+*/
+class Allocation
+{
+    friend class Allocator;
+
+    /* owning memory block, nullptr for an empty allocation */
+    void* m_pBlock{ nullptr };
+    /* buddy order of the range, unused for dedicated allocations */
+    uint32_t m_Order{ 0 };
+
+public:
+    VkDeviceMemory Memory{ VK_NULL_HANDLE };
+    VkDeviceSize Offset{ 0 };
+    VkDeviceSize Size{ 0 };
+    uint32_t MemoryType{ 0 };
+
+    explicit operator bool() const noexcept
+    {
+        return VK_NULL_HANDLE != Memory;
+    }
+};
+
+/**
+* MemoryUsage enum
+* @brief how the memory of a resource is accessed, memory types are ranked by how well they fit it
+*/
+enum class MemoryUsage
+{
+    /* only touched by the GPU: attachments, textures, static geometry */
+    GpuOnly,
+    /* written once by the CPU and copied by the GPU: staging buffers */
+    Upload,
+    /* written by the GPU and read by the CPU */
+    Readback,
+    /* rewritten by the CPU and read by the GPU every frame: uniforms, dynamic geometry */
+    CpuToGpu,
+};
+
+/**
+* HeapStats struct
+* @brief usage of one memory heap, Usage and Budget come from VK_EXT_memory_budget when available
+*/
+struct HeapStats
+{
+    /* VkDeviceMemory objects allocated by the library and their total size */
+    uint32_t BlockCount{ 0 };
+    VkDeviceSize BlockBytes{ 0 };
+    /* resources bound to those blocks and the bytes they take */
+    uint32_t AllocationCount{ 0 };
+    VkDeviceSize AllocationBytes{ 0 };
+    /* heap usage of the whole process and how much it may use, estimated without the extension */
+    VkDeviceSize Usage{ 0 };
+    VkDeviceSize Budget{ 0 };
+};
+
+struct MemoryStats
+{
+    uint32_t HeapCount{ 0 };
+    std::array<HeapStats, VK_MAX_MEMORY_HEAPS> Heaps{};
+    /* true when Usage and Budget are reported by the driver */
+    bool BudgetQueried{ false };
+};
+
+/**
+* Allocator class
+* @brief carves resources out of large VkDeviceMemory blocks, one set of blocks per memory type
+*
+* Each block is managed as a binary buddy heap: an allocation is rounded up to the next power of two
+* no smaller than its alignment, so every sub-range is naturally aligned inside its block.
+* Linear (buffer) and non-linear (optimal tiling image) resources are kept in separate blocks when
+* the device reports a bufferImageGranularity larger than 1, so they never share a granularity page.
+* Requests too large for a block fall back to a dedicated VkDeviceMemory.
+*/
+class Allocator : public NonCopyable
+{
+    struct Block
+    {
+        VkDeviceMemory Memory{ VK_NULL_HANDLE };
+        VkDeviceSize Size{ 0 };
+        uint32_t MemoryType{ 0 };
+        size_t PoolIndex{ 0 };
+        bool Dedicated{ false };
+        /* free offsets indexed by buddy order */
+        std::vector<std::set<VkDeviceSize>> FreeLists;
+        VkDeviceSize Used{ 0 };
+        void* pMapped{ nullptr };
+        uint32_t MapCount{ 0 };
+    };
+
+    struct Pool
+    {
+        uint32_t MemoryType;
+        bool Linear;
+        VkMemoryAllocateFlags Flags;
+        uint32_t MaxOrder;
+        std::vector<std::unique_ptr<Block>> Blocks;
+    };
+
+    Device const& m_Device;
+    VkDeviceSize m_PreferredBlockSize;
+    std::vector<Pool> m_Pools;
+    std::array<HeapStats, VK_MAX_MEMORY_HEAPS> m_HeapStats;
+    std::mutex m_Mutex;
+
+    HeapStats& GetTypeHeapStats(uint32_t memoryType) noexcept;
+
+    Pool& GetPool(uint32_t memoryType, bool linear, VkMemoryAllocateFlags flags) noexcept;
+    static bool TakeRange(Block& block, uint32_t order, VkDeviceSize& offset) noexcept;
+    static void ReturnRange(Block& block, uint32_t order, VkDeviceSize offset) noexcept;
+    VkResult AllocateMemory(uint32_t memoryType, VkDeviceSize size, VkMemoryAllocateFlags flags, Block& block) noexcept;
+    VkResult AllocateOfType(
+        VkMemoryRequirements const& memReqs,
+        uint32_t memoryType,
+        bool linear,
+        Allocation& allocation,
+        VkMemoryAllocateFlags allocateFlags
+    ) noexcept;
+    void FreeMemory(Block& block) noexcept;
+
+public:
+    /** @brief smallest range handed out from a block, 2^MIN_ORDER bytes */
+    static constexpr uint32_t MIN_ORDER = 8;
+    static constexpr VkDeviceSize DEFAULT_BLOCK_SIZE = 64ull * 1024 * 1024;
+
+    VkResult Allocate(
+        VkMemoryRequirements const& memReqs,
+        MemoryUsage usage,
+        bool linear,
+        Allocation& allocation,
+        VkMemoryAllocateFlags allocateFlags = 0
+    ) noexcept;
+    void Free(Allocation& allocation) noexcept;
+    VkResult Map(Allocation const& allocation, void** ppData) noexcept;
+    void Unmap(Allocation const& allocation) noexcept;
+    std::array<HeapStats, VK_MAX_MEMORY_HEAPS> GetHeapStats(void) noexcept;
+
+    Allocator(Device const& device, VkDeviceSize preferredBlockSize = DEFAULT_BLOCK_SIZE) noexcept;
+    ~Allocator(void) noexcept;
+};
+}
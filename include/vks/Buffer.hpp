@@ -3,6 +3,7 @@
 
 #include <vulkan/vulkan.h>
 
+#include "vks/Allocator.hpp"
 #include "vks/VulkanEncapsulate.hpp"
 
 namespace vks
@@ -13,23 +14,42 @@ class Buffer : public VulkanEncapsulate<VkBuffer>
 {
     Device const& m_Device;
 
-    VkDeviceMemory m_Memory;
+    Allocation m_Allocation;
     VkDeviceSize m_Size;
     void* m_pMapped;
 
+    /* persistently mapped buffers stay mapped from construction to destruction */
+    bool m_Persistent;
+    bool m_Coherent;
+    /* byte range written since the last FlushDirty, empty when begin >= end */
+    VkDeviceSize m_DirtyBegin;
+    VkDeviceSize m_DirtyEnd;
+
+    VkMappedMemoryRange GetMappedRange(VkDeviceSize size, VkDeviceSize offset) const noexcept;
+
 public:
     VkResult Flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const noexcept;
+    VkResult Invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) const noexcept;
     VkResult Map(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0, VkMemoryMapFlags flags = 0) noexcept;
     void Unmap(void) noexcept;
-    void CopyData(const void* data, size_t size) noexcept;
+    void CopyData(const void* data, size_t size, VkDeviceSize offset = 0) noexcept;
     void CopyFrom(Buffer& src, std::optional<VkBufferCopy> bufferCopy = std::nullopt) const noexcept;
 
+    void MarkDirty(VkDeviceSize offset, VkDeviceSize size) noexcept;
+    VkResult FlushDirty(void) noexcept;
+
+    Allocation const& GetAllocation(void) const noexcept;
+    VkDeviceSize GetSize(void) const noexcept;
+    void* GetMappedData(void) const noexcept;
+    bool IsPersistent(void) const noexcept;
+
     Buffer(
         Device const& device,
         VkBufferUsageFlags usageFlags,
-        VkMemoryPropertyFlags memoryPropertyFlags,
+        MemoryUsage usage,
         VkDeviceSize size,
-        void* data = nullptr
+        void* data = nullptr,
+        bool persistent = false
         ) noexcept;
     ~Buffer(void) noexcept;
 };
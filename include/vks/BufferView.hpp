@@ -0,0 +1,99 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Buffer.hpp"
+
+namespace vks
+{
+/**
+* BufferView class
+* @brief typed, zero-copy access to a range of a persistently mapped vks::Buffer
+*
+* Writes land directly in the mapped memory. Write() records the touched elements as dirty,
+* writes made through Span() or operator[] need a matching MarkDirty() before Flush().
+*/
+template<typename T>
+class BufferView
+{
+    static_assert(std::is_trivially_copyable_v<T>, "BufferView elements are copied to the GPU byte for byte");
+
+    Buffer* m_pBuffer;
+    VkDeviceSize m_Offset;
+    size_t m_Count;
+
+public:
+    /**
+    * @param buffer a persistently mapped buffer
+    * @param offset byte offset of the first element, must be aligned to alignof(T)
+    * @param count number of elements, defaults to every whole element after offset
+    */
+    BufferView(Buffer& buffer, VkDeviceSize offset = 0, size_t count = SIZE_MAX) noexcept
+        : m_pBuffer(&buffer), m_Offset(offset), m_Count(count)
+    {
+        assert(buffer.IsPersistent());
+        assert(0 == offset % alignof(T));
+        if (SIZE_MAX == m_Count)
+        {
+            m_Count = static_cast<size_t>((buffer.GetSize() - offset) / sizeof(T));
+        }
+        assert(offset + m_Count * sizeof(T) <= buffer.GetSize());
+    }
+
+    T* Data(void) const noexcept
+    {
+        return reinterpret_cast<T*>(static_cast<uint8_t*>(m_pBuffer->GetMappedData()) + m_Offset);
+    }
+
+    size_t Count(void) const noexcept
+    {
+        return m_Count;
+    }
+
+    std::span<T> Span(void) const noexcept
+    {
+        return std::span<T>(Data(), m_Count);
+    }
+
+    T& operator[](size_t index) const noexcept
+    {
+        assert(index < m_Count);
+        return Data()[index];
+    }
+
+    void Write(size_t index, T const& value) noexcept
+    {
+        assert(index < m_Count);
+        Data()[index] = value;
+        MarkDirty(index, 1);
+    }
+
+    void Write(size_t first, std::span<const T> values) noexcept
+    {
+        assert(first + values.size() <= m_Count);
+        std::copy(values.begin(), values.end(), Data() + first);
+        MarkDirty(first, values.size());
+    }
+
+    void MarkDirty(size_t first = 0, size_t count = SIZE_MAX) noexcept
+    {
+        if (SIZE_MAX == count)
+        {
+            count = m_Count - first;
+        }
+        m_pBuffer->MarkDirty(m_Offset + first * sizeof(T), count * sizeof(T));
+    }
+
+    /** @brief flush every range of the underlying buffer marked dirty so far */
+    VkResult Flush(void) noexcept
+    {
+        return m_pBuffer->FlushDirty();
+    }
+};
+}
@@ -1,11 +1,14 @@
 #pragma once
 
+#include <mutex>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <vulkan/vulkan.h>
 
+#include "vks/Allocator.hpp"
 #include "vks/Buffer.hpp"
 #include "vks/VulkanEncapsulate.hpp"
 
@@ -21,18 +24,57 @@ class Device : public VulkanEncapsulate<VkDevice>
 	std::vector<VkQueueFamilyProperties> m_QueueFamilyProperties;
 	std::vector<std::string> m_SupportedExtensions;
 
-	/* this command pool is created with graphics queue, for buffer operation that needs a command pool */
-	VkCommandPool m_CmdPool;
-	friend void Buffer::CopyFrom(Buffer& src, std::optional<VkBufferCopy> bufferCopy) const noexcept;
+	/* sub-allocator every Buffer and FramebufferAttachment of this device takes its memory from */
+	Allocator* m_pAllocator;
+	/* VK_EXT_memory_budget is enabled and vkGetPhysicalDeviceMemoryProperties2KHR is loaded */
+	bool m_MemoryBudget;
+
+	/* a transient command pool of the graphics family with its single command buffer, for one-time submits */
+	struct OneTimeCommands
+	{
+		VkCommandPool Pool;
+		VkCommandBuffer CmdBuffer;
+	};
+	/* every one-time command buffer with its own pool, so threads never record into a shared pool */
+	mutable std::unordered_map<VkCommandBuffer, VkCommandPool> m_OneTimePools;
+	/* recycled one-time command buffers and unsignaled fences for blocking submits */
+	mutable std::vector<OneTimeCommands> m_FreeOneTimeCommands;
+	mutable std::vector<VkFence> m_FreeFences;
+	mutable std::mutex m_RecycleMutex;
+
+	/* every pipeline of the library is created with this cache, loaded from and saved to m_PipelineCachePath */
+	VkPipelineCache m_PipelineCache;
+	std::string m_PipelineCachePath;
+	/* caches handed to worker threads, saved along with m_PipelineCache */
+	mutable std::vector<VkPipelineCache> m_ThreadPipelineCaches;
+	mutable std::mutex m_PipelineCacheMutex;
+
+	OneTimeCommands CreateOneTimeCommands(void) const noexcept;
+	VkFence AcquireFence(void) const noexcept;
+	void ReleaseFence(VkFence fence) const noexcept;
+	bool ValidatePipelineCacheHeader(std::vector<uint8_t> const& data) const noexcept;
+	std::vector<uint8_t> GetPipelineCacheData(VkPipelineCache cache) const noexcept;
+	void CreatePipelineCache(void) noexcept;
 
 	std::optional<uint32_t> GetQueueFamilyIndex(VkQueueFlags queueFlags) const noexcept;
 
 public:
 	VkPhysicalDevice const& GetPhysicalDevice(void) const noexcept;
+	VkPhysicalDeviceProperties const& GetProperties(void) const noexcept;
+	VkPhysicalDeviceMemoryProperties const& GetMemoryProperties(void) const noexcept;
+	Allocator& GetAllocator(void) const noexcept;
+	MemoryStats GetMemoryStats(void) const noexcept;
 	bool ExtensionSupported(const std::string& name) const noexcept;
 	void SubmitCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue) const noexcept;
+	VkCommandBuffer BeginOneTimeCommandBuffer(void) const noexcept;
+	void FlushOneTimeCommandBuffer(VkCommandBuffer commandBuffer, VkQueue queue) const noexcept;
 	std::optional<VkFormat> SupportedDepthStencilFormat(void) const noexcept;
 	std::optional<uint32_t> GetMemoryType(uint32_t memoryTypeBits, VkMemoryPropertyFlags properties) const noexcept;
+	std::optional<uint32_t> GetMemoryType(uint32_t memoryTypeBits, MemoryUsage usage) const noexcept;
+	std::vector<uint32_t> RankMemoryTypes(uint32_t memoryTypeBits, MemoryUsage usage) const noexcept;
+	VkPipelineCache GetPipelineCache(void) const noexcept;
+	VkPipelineCache CreateThreadPipelineCache(void) const noexcept;
+	bool SavePipelineCache(void) const noexcept;
 
 	struct
 	{
@@ -41,12 +83,15 @@ public:
 		uint32_t Transfer;
 	} QueueIndex;
 
+	static void LoadInstanceFunctions(VkInstance instance) noexcept;
+
 	Device(
 		VkPhysicalDevice gpu,
 		VkPhysicalDeviceFeatures enabledFeatures = {},
 		std::vector<const char*> enabledExtensions = {},
 		void* pNextChain = nullptr,
-		VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT
+		VkQueueFlags requestedQueueTypes = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
+		std::string pipelineCachePath = {}
 	) noexcept;
 	~Device(void);
 };
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <optional>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Buffer.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* FrameArena class
+* @brief per-frame bump allocator for transient uniform, vertex and index data
+*
+* One persistently mapped buffer is split into a slice per frame in flight. Allocate bumps the
+* head of the current slice, BeginFrame resets the slice of a frame once its fence has signaled.
+* Every allocation of an arena shares the same VkBuffer, so offsets can be used as dynamic offsets.
+*/
+class FrameArena : public NonCopyable
+{
+public:
+    struct Suballocation
+    {
+        VkBuffer Buffer;
+        /* offset from the start of Buffer, aligned for dynamic uniform buffer offsets */
+        VkDeviceSize Offset;
+        void* pData;
+    };
+
+private:
+    Device const& m_Device;
+    Buffer* m_pBuffer;
+    uint32_t m_FrameCount;
+    VkDeviceSize m_SliceSize;
+    VkDeviceSize m_MinAlignment;
+
+    uint32_t m_CurrentFrame;
+    /* bytes handed out from the current slice, bumped from any recording thread */
+    std::atomic<VkDeviceSize> m_Head;
+
+public:
+    std::optional<Suballocation> Allocate(VkDeviceSize size, VkDeviceSize alignment = 0) noexcept;
+    void BeginFrame(uint32_t frameIndex) noexcept;
+    VkResult Flush(void) noexcept;
+
+    VkBuffer GetBuffer(void) const noexcept;
+    VkDeviceSize GetSliceSize(void) const noexcept;
+    VkDeviceSize GetUsed(void) const noexcept;
+
+    FrameArena(
+        Device const& device,
+        uint32_t frameCount,
+        VkDeviceSize sliceSize,
+        VkBufferUsageFlags usageFlags = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT
+    ) noexcept;
+    ~FrameArena(void) noexcept;
+};
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Buffer.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* FrameCapture class
+* @brief copies rendered images into a ring of host cached readback buffers and hands them to worker threads
+*
+* RecordCopy appends the copy of the frame's image to the frame's command buffer, so presentation still
+* waits for it, and Submit follows the frame's vkQueueSubmit with an empty submit signaling the slot's
+* fence. Workers wait on the fences, invalidate the mapped memory and call the capture callback with the
+* pixels. A slot is reused once its callback returned. When every slot is busy the frame is dropped and
+* counted by default so the render thread never blocks, jobs that need every frame, e.g. regression tests
+* or video export, use Overflow::Wait to stall the render thread until a slot is free instead.
+*/
+class FrameCapture : public NonCopyable
+{
+public:
+    struct Frame
+    {
+        uint64_t Index;
+        VkExtent2D Extent;
+        VkFormat Format;
+        /* tightly packed rows of Extent.width pixels, valid for the duration of the callback */
+        void const* pData;
+        VkDeviceSize Size;
+    };
+
+    /** @brief called on a worker thread, concurrently for different frames and not necessarily in order */
+    using CaptureFunc = std::function<void(Frame const& frame)>;
+
+    /** @brief what RecordCopy does when every readback slot is in use */
+    enum class Overflow
+    {
+        Drop,
+        Wait,
+    };
+
+    static constexpr uint32_t DEFAULT_SLOT_COUNT = 4;
+
+private:
+    enum class SlotState
+    {
+        Free,
+        Recorded,
+        Submitted,
+    };
+
+    struct Slot
+    {
+        Buffer* pBuffer;
+        VkFence Fence;
+        uint64_t Frame;
+        SlotState State;
+    };
+
+    Device const& m_Device;
+    CaptureFunc m_Capture;
+    VkExtent2D m_Extent;
+    VkFormat m_Format;
+    VkDeviceSize m_FrameSize;
+    Overflow m_Overflow;
+
+    /* requested ring size, m_Slots is empty while the extent has no area or the format is not supported */
+    uint32_t m_SlotCount;
+    std::vector<Slot> m_Slots;
+    /* slot recorded by the last RecordCopy, submitted by the next Submit */
+    std::optional<uint32_t> m_Recorded;
+    uint64_t m_FrameIndex;
+    uint64_t m_DroppedFrames;
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkCv;
+    std::condition_variable m_FreeCv;
+    /* submitted slots in submission order */
+    std::deque<uint32_t> m_Submitted;
+    uint32_t m_Busy;
+    bool m_Stop;
+
+    void CreateSlots(void) noexcept;
+    void DestroySlots(void) noexcept;
+    void WorkerLoop(void) noexcept;
+
+public:
+    std::optional<uint64_t> RecordCopy(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout layout) noexcept;
+    void Submit(VkQueue queue) noexcept;
+    void WaitIdle(void) noexcept;
+    void Resize(VkExtent2D extent) noexcept;
+
+    uint64_t GetDroppedFrames(void) const noexcept;
+
+    FrameCapture(
+        Device const& device,
+        VkExtent2D extent,
+        VkFormat format,
+        CaptureFunc capture,
+        uint32_t slotCount = DEFAULT_SLOT_COUNT,
+        uint32_t threadCount = 2,
+        Overflow overflow = Overflow::Drop
+    ) noexcept;
+    ~FrameCapture(void) noexcept;
+};
+}
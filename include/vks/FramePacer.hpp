@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+class Swapchain;
+
+/**
+* FramePacer class
+* @brief keeps the present queue short by waiting for earlier presents before the next frame starts
+*
+* Every present goes through the pacer and is tagged with an increasing present id. WaitForLatency, called
+* before input is sampled, blocks in vkWaitForPresentKHR until at most the target latency of presents are
+* still queued, so FIFO stays one frame deep at a latency of 1 without tearing. The time each waited
+* present completed is recorded to measure present-to-present intervals. Without VK_KHR_present_wait and
+* VK_KHR_present_id enabled on the device presents are untagged and WaitForLatency returns at once.
+*/
+class FramePacer : public NonCopyable
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr size_t INTERVAL_HISTORY = 64;
+    /* a present that never completes, e.g. on a minimized window, must not hang the frame loop */
+    static constexpr uint64_t DEFAULT_WAIT_TIMEOUT = 100000000;
+
+private:
+    Device const& m_Device;
+    Swapchain const& m_Swapchain;
+    bool m_Enabled;
+
+    uint32_t m_TargetLatency;
+    uint64_t m_WaitTimeout;
+
+    /* last id presented, first id presented to the current swapchain handle, last id known complete */
+    uint64_t m_PresentId;
+    uint64_t m_FirstPresentId;
+    uint64_t m_CompletedId;
+    VkSwapchainKHR m_LastSwapchain;
+
+    /* completion time of the last waited present and a ring of intervals between waited presents */
+    Clock::time_point m_LastCompletion;
+    uint64_t m_LastCompletionId;
+    std::array<Clock::duration, INTERVAL_HISTORY> m_Intervals;
+    size_t m_IntervalCount;
+
+public:
+    VkResult QueuePresent(VkQueue queue) noexcept;
+    VkResult WaitForLatency(void) noexcept;
+
+    void SetTargetLatency(uint32_t frames) noexcept;
+    void SetWaitTimeout(uint64_t timeout) noexcept;
+
+    bool IsEnabled(void) const noexcept;
+    uint32_t GetTargetLatency(void) const noexcept;
+    uint64_t GetPresentId(void) const noexcept;
+    uint64_t GetCompletedId(void) const noexcept;
+    Clock::duration GetLastInterval(void) const noexcept;
+    Clock::duration GetAverageInterval(void) const noexcept;
+
+    FramePacer(Device const& device, Swapchain const& swapchain, uint32_t targetLatency = 1) noexcept;
+    ~FramePacer(void) noexcept = default;
+};
+}
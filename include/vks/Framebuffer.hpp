@@ -17,7 +17,8 @@ class FramebufferAttachment : public NonCopyable
 
 	VkImage m_Image;
 	VkImageView m_ImageView;
-	VkDeviceMemory m_Memory;
+	Allocation m_Allocation;
+	MemoryUsage m_Usage;
 	VkAttachmentDescription m_Description;
 
 	void Init(void);
@@ -25,12 +26,24 @@ class FramebufferAttachment : public NonCopyable
 
 public:
 	void Recreate(VkExtent3D extent) noexcept;
+	VkImage const& GetImage(void) const noexcept;
 	VkImageView const& GetView(void) const noexcept;
+	VkFormat GetFormat(void) const noexcept;
+	VkRenderingAttachmentInfoKHR GetRenderingAttachmentInfo(
+		VkImageLayout layout,
+		VkAttachmentLoadOp loadOp,
+		VkAttachmentStoreOp storeOp,
+		VkClearValue clearValue = {}
+	) const noexcept;
+	VkImageCreateInfo const& GetImageCreateInfo(void) const noexcept;
+	VkImageViewCreateInfo const& GetImageViewCreateInfo(void) const noexcept;
+	MemoryUsage GetUsage(void) const noexcept;
 
 	FramebufferAttachment(
 		Device const& device,
 		VkImageCreateInfo const& imageCI,
-		VkImageViewCreateInfo& imageViewCI
+		VkImageViewCreateInfo& imageViewCI,
+		MemoryUsage usage = MemoryUsage::GpuOnly
 	) noexcept;
 	~FramebufferAttachment(void) noexcept;
 };
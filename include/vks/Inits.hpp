@@ -151,6 +151,80 @@ inline VkMemoryBarrier memoryBarrier()
 	return memoryBarrier;
 }
 
+/** @brief Initialize a synchronization2 image memory barrier with no image transfer ownership */
+inline VkImageMemoryBarrier2KHR imageMemoryBarrier2()
+{
+	VkImageMemoryBarrier2KHR imageMemoryBarrier{};
+	imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2;
+	imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	return imageMemoryBarrier;
+}
+
+inline VkMemoryBarrier2KHR memoryBarrier2()
+{
+	VkMemoryBarrier2KHR memoryBarrier{};
+	memoryBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+	return memoryBarrier;
+}
+
+inline VkDependencyInfoKHR dependencyInfo()
+{
+	VkDependencyInfoKHR dependencyInfo{};
+	dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+	return dependencyInfo;
+}
+
+inline VkRenderingAttachmentInfoKHR renderingAttachmentInfo(
+	VkImageView imageView,
+	VkImageLayout imageLayout,
+	VkAttachmentLoadOp loadOp,
+	VkAttachmentStoreOp storeOp,
+	VkClearValue clearValue = {}
+)
+{
+	VkRenderingAttachmentInfoKHR renderingAttachmentInfo{};
+	renderingAttachmentInfo.sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO;
+	renderingAttachmentInfo.imageView = imageView;
+	renderingAttachmentInfo.imageLayout = imageLayout;
+	renderingAttachmentInfo.loadOp = loadOp;
+	renderingAttachmentInfo.storeOp = storeOp;
+	renderingAttachmentInfo.clearValue = clearValue;
+	return renderingAttachmentInfo;
+}
+
+inline VkRenderingInfoKHR renderingInfo()
+{
+	VkRenderingInfoKHR renderingInfo{};
+	renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO;
+	return renderingInfo;
+}
+
+/** @brief Chain into VkGraphicsPipelineCreateInfo to create a pipeline for dynamic rendering */
+inline VkPipelineRenderingCreateInfoKHR pipelineRenderingCreateInfo()
+{
+	VkPipelineRenderingCreateInfoKHR pipelineRenderingCreateInfo{};
+	pipelineRenderingCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO;
+	return pipelineRenderingCreateInfo;
+}
+
+inline VkGraphicsPipelineLibraryCreateInfoEXT graphicsPipelineLibraryCreateInfo(VkGraphicsPipelineLibraryFlagsEXT flags)
+{
+	VkGraphicsPipelineLibraryCreateInfoEXT graphicsPipelineLibraryCreateInfo{};
+	graphicsPipelineLibraryCreateInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT;
+	graphicsPipelineLibraryCreateInfo.flags = flags;
+	return graphicsPipelineLibraryCreateInfo;
+}
+
+inline VkPipelineLibraryCreateInfoKHR pipelineLibraryCreateInfo(uint32_t libraryCount, const VkPipeline* pLibraries)
+{
+	VkPipelineLibraryCreateInfoKHR pipelineLibraryCreateInfo{};
+	pipelineLibraryCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR;
+	pipelineLibraryCreateInfo.libraryCount = libraryCount;
+	pipelineLibraryCreateInfo.pLibraries = pLibraries;
+	return pipelineLibraryCreateInfo;
+}
+
 inline VkImageCreateInfo imageCreateInfo(
 	VkImageCreateFlags flags = VK_FLAGS_NONE,
 	VkImageType imageType = VK_IMAGE_TYPE_1D,
@@ -300,6 +374,20 @@ inline VkDescriptorPoolCreateInfo descriptorPoolCreateInfo(
 	return descriptorPoolInfo;
 }
 
+inline VkDescriptorSetLayoutBinding descriptorSetLayoutBinding(
+	VkDescriptorType type,
+	VkShaderStageFlags stageFlags,
+	uint32_t binding,
+	uint32_t descriptorCount = 1)
+{
+	VkDescriptorSetLayoutBinding setLayoutBinding{};
+	setLayoutBinding.descriptorType = type;
+	setLayoutBinding.stageFlags = stageFlags;
+	setLayoutBinding.binding = binding;
+	setLayoutBinding.descriptorCount = descriptorCount;
+	return setLayoutBinding;
+}
+
 inline VkDescriptorSetLayoutCreateInfo descriptorSetLayoutCreateInfo(
 	const VkDescriptorSetLayoutBinding* pBindings,
 	uint32_t bindingCount)
@@ -527,6 +615,19 @@ inline VkPipelineTessellationStateCreateInfo pipelineTessellationStateCreateInfo
 	return pipelineTessellationStateCreateInfo;
 }
 
+inline VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo(
+	VkShaderStageFlagBits stage,
+	VkShaderModule module,
+	const char* pName = "main")
+{
+	VkPipelineShaderStageCreateInfo pipelineShaderStageCreateInfo{};
+	pipelineShaderStageCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineShaderStageCreateInfo.stage = stage;
+	pipelineShaderStageCreateInfo.module = module;
+	pipelineShaderStageCreateInfo.pName = pName;
+	return pipelineShaderStageCreateInfo;
+}
+
 inline VkGraphicsPipelineCreateInfo pipelineCreateInfo(
 	VkPipelineLayout layout,
 	VkRenderPass renderPass,
@@ -564,6 +665,17 @@ inline VkComputePipelineCreateInfo computePipelineCreateInfo(
 	return computePipelineCreateInfo;
 }
 
+inline VkPipelineCacheCreateInfo pipelineCacheCreateInfo(
+	size_t initialDataSize = 0,
+	const void* pInitialData = nullptr)
+{
+	VkPipelineCacheCreateInfo pipelineCacheCreateInfo{};
+	pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+	pipelineCacheCreateInfo.initialDataSize = initialDataSize;
+	pipelineCacheCreateInfo.pInitialData = pInitialData;
+	return pipelineCacheCreateInfo;
+}
+
 inline VkPushConstantRange pushConstantRange(
 	VkShaderStageFlags stageFlags,
 	uint32_t size,
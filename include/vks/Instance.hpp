@@ -1,5 +1,6 @@
 #pragma once
 
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -17,14 +18,18 @@ class Instance : public VulkanEncapsulate<VkInstance>
 {
     /** @brief fetched supported instance extensions */
     std::vector<std::string> m_SupportedExtensions;
+    /** @brief VK_EXT_headless_surface was enabled by a headless instance */
+    bool m_HeadlessSurface;
 
 public:
     bool ExtensionSupported(const std::string& name);
+    std::optional<VkSurfaceKHR> CreateHeadlessSurface(void) const noexcept;
 
     Instance(
         VkApplicationInfo appInfo,
         bool validation = true,
-        std::vector<const char*> enabledExtensions = {}
+        std::vector<const char*> enabledExtensions = {},
+        bool headless = false
         ) noexcept;
     ~Instance(void);
 };
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* ParallelRecorder class
+* @brief records secondary command buffers on worker threads, one command pool per thread and frame in flight
+*
+* Record splits the scene into slices that workers record into secondary command buffers continuing a
+* render pass, ExecuteInRenderPass then replays them from the main thread's primary command buffer.
+* Command pools are never shared between threads, so recording needs no locking, and the pools of a
+* frame are reset as a whole by BeginFrame once that frame's fence has signaled.
+*/
+class ParallelRecorder : public NonCopyable
+{
+public:
+    /** @brief records one slice, the command buffer is begun and ended by the recorder */
+    using RecordFunc = std::function<void(VkCommandBuffer cmdBuffer, uint32_t slice)>;
+
+private:
+    struct ThreadPool
+    {
+        VkCommandPool Pool;
+        std::vector<VkCommandBuffer> CmdBuffers;
+        /* command buffers handed out since the last reset */
+        uint32_t Used;
+    };
+
+    Device const& m_Device;
+    uint32_t m_FrameCount;
+    uint32_t m_ThreadCount;
+    uint32_t m_CurrentFrame;
+    /* indexed by frame * thread count + thread */
+    std::vector<ThreadPool> m_Pools;
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkCv;
+    std::condition_variable m_DoneCv;
+    uint64_t m_Generation;
+    uint32_t m_WorkersDone;
+    bool m_Stop;
+
+    /* job of the current Record call */
+    RecordFunc m_Record;
+    VkCommandBufferInheritanceInfo m_Inheritance;
+    uint32_t m_SliceCount;
+    std::atomic<uint32_t> m_NextSlice;
+    std::vector<VkCommandBuffer> m_Recorded;
+
+    VkCommandBuffer GetCommandBuffer(uint32_t threadIndex) noexcept;
+    void WorkerLoop(uint32_t threadIndex) noexcept;
+
+public:
+    void BeginFrame(uint32_t frameIndex) noexcept;
+    std::vector<VkCommandBuffer> const& Record(
+        VkRenderPass renderPass,
+        uint32_t subpass,
+        VkFramebuffer framebuffer,
+        uint32_t sliceCount,
+        RecordFunc record
+    ) noexcept;
+    void ExecuteInRenderPass(VkCommandBuffer primary, VkRenderPassBeginInfo const& renderPassBeginInfo) const noexcept;
+
+    uint32_t GetThreadCount(void) const noexcept;
+
+    ParallelRecorder(
+        Device const& device,
+        uint32_t queueFamilyIndex,
+        uint32_t frameCount,
+        uint32_t threadCount = std::thread::hardware_concurrency()
+    ) noexcept;
+    ~ParallelRecorder(void) noexcept;
+};
+}
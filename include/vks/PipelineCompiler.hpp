@@ -0,0 +1,156 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* @brief shader stage of a pipeline description, owns its entry point and specialization constants
+*/
+struct ShaderStageDesc
+{
+    VkShaderStageFlagBits Stage;
+    VkShaderModule Module;
+    std::string EntryPoint = "main";
+    std::vector<VkSpecializationMapEntry> SpecializationEntries;
+    std::vector<uint8_t> SpecializationData;
+};
+
+/**
+* @brief graphics pipeline state that owns every array it refers to, so it can be compiled after the
+* caller's locals are gone, defaults are an opaque triangle list with depth test and dynamic viewport
+*/
+struct GraphicsPipelineDesc
+{
+    std::vector<ShaderStageDesc> Stages;
+    std::vector<VkVertexInputBindingDescription> VertexBindings;
+    std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+    VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkBool32 PrimitiveRestart = VK_FALSE;
+    VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+    VkBool32 DepthTest = VK_TRUE;
+    VkBool32 DepthWrite = VK_TRUE;
+    VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    /* one per color attachment */
+    std::vector<VkPipelineColorBlendAttachmentState> BlendAttachments;
+    std::vector<VkDynamicState> DynamicStates = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineLayout Layout = VK_NULL_HANDLE;
+    VkRenderPass RenderPass = VK_NULL_HANDLE;
+    uint32_t Subpass = 0;
+    /* attachment formats for dynamic rendering, used when RenderPass is VK_NULL_HANDLE */
+    std::vector<VkFormat> ColorFormats;
+    VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+    VkFormat StencilFormat = VK_FORMAT_UNDEFINED;
+    VkPipelineCreateFlags Flags = 0;
+    /* VK_EXT_graphics_pipeline_library, non zero to create a library of only these parts of the pipeline */
+    VkGraphicsPipelineLibraryFlagsEXT LibraryParts = 0;
+    /* libraries linked into the pipeline, which then takes no stages nor state of its own but Layout and Flags */
+    std::vector<VkPipeline> Libraries;
+};
+
+struct ComputePipelineDesc
+{
+    ShaderStageDesc Stage{ VK_SHADER_STAGE_COMPUTE_BIT, VK_NULL_HANDLE };
+    VkPipelineLayout Layout = VK_NULL_HANDLE;
+    VkPipelineCreateFlags Flags = 0;
+};
+
+/**
+* PipelineCompiler class
+* @brief compiles batches of pipeline descriptions on a thread pool
+*
+* Compile queues the descriptions and returns a handle per pipeline at once, workers take them one at a
+* time and create them with a pipeline cache of their own from Device::CreateThreadPipelineCache. The
+* renderer polls a handle every frame and draws with a fallback pipeline until it is ready. Compiled
+* pipelines are owned by the compiler and destroyed with it, shader modules and layouts must outlive the
+* compilation of the pipelines using them.
+*/
+class PipelineCompiler : public NonCopyable
+{
+public:
+    enum class Status : uint8_t
+    {
+        Pending,
+        Ready,
+        Failed,
+    };
+
+    class Result
+    {
+        friend class PipelineCompiler;
+
+        VkPipeline m_Pipeline = VK_NULL_HANDLE;
+        std::atomic<Status> m_Status{ Status::Pending };
+
+    public:
+        /** @brief the pipeline once ready, VK_NULL_HANDLE while pending or if compilation failed */
+        VkPipeline Get(void) const noexcept;
+        Status GetStatus(void) const noexcept;
+        bool IsReady(void) const noexcept;
+    };
+
+    /** @brief stays valid for the lifetime of the compiler, polling it never blocks */
+    using Handle = Result const*;
+
+private:
+    struct Job
+    {
+        Result* pResult;
+        std::variant<GraphicsPipelineDesc, ComputePipelineDesc> Desc;
+    };
+
+    Device const& m_Device;
+
+    std::vector<std::thread> m_Workers;
+    std::mutex m_Mutex;
+    std::condition_variable m_WorkCv;
+    std::condition_variable m_IdleCv;
+    std::deque<Job> m_Jobs;
+    /* stable addresses, handles point into it */
+    std::deque<Result> m_Results;
+    /* queued plus compiling jobs */
+    uint32_t m_Pending;
+    bool m_Stop;
+
+    void WorkerLoop(void) noexcept;
+    template <typename Desc>
+    std::vector<Handle> Enqueue(std::vector<Desc>& descs) noexcept;
+
+public:
+    static VkResult Create(VkDevice device, GraphicsPipelineDesc const& desc, VkPipelineCache cache, VkPipeline* pPipeline) noexcept;
+    static VkResult Create(VkDevice device, ComputePipelineDesc const& desc, VkPipelineCache cache, VkPipeline* pPipeline) noexcept;
+
+    std::vector<Handle> Compile(std::vector<GraphicsPipelineDesc> descs) noexcept;
+    std::vector<Handle> Compile(std::vector<ComputePipelineDesc> descs) noexcept;
+    Handle Compile(GraphicsPipelineDesc desc) noexcept;
+    Handle Compile(ComputePipelineDesc desc) noexcept;
+    void WaitIdle(void) noexcept;
+
+    uint32_t GetPendingCount(void) noexcept;
+    uint32_t GetThreadCount(void) const noexcept;
+
+    PipelineCompiler(
+        Device const& device,
+        uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 2u) - 1
+    ) noexcept;
+    ~PipelineCompiler(void) noexcept;
+};
+}
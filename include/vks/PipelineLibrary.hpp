@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/PipelineCompiler.hpp"
+#include "vks/PipelineState.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* PipelineLibrary class
+* @brief graphics pipelines fast-linked from separately cached parts, replaced by optimized links compiled
+* in the background, with VK_EXT_graphics_pipeline_library
+*
+* A state is split into its vertex input, pre-rasterization, fragment and fragment output parts, each keyed
+* by the fields of the state it depends on and compiled into a library once, so a new combination of known
+* shaders and state only costs a link. The first Get of a state links the parts without optimization on the
+* calling thread and queues a link time optimized link on the compiler, Get returns it once ready. Without
+* the extension Get creates the whole pipeline on the calling thread like vks::PipelineStateCache.
+*/
+class PipelineLibrary : public NonCopyable
+{
+    static constexpr uint32_t PART_COUNT = 4;
+
+    struct Entry
+    {
+        VkPipeline FastLinked;
+        /* nullptr without the extension, FastLinked is then the complete pipeline */
+        PipelineCompiler::Handle Optimized;
+    };
+
+    Device const& m_Device;
+    PipelineCompiler& m_Compiler;
+    bool m_LibraryEnabled;
+
+    std::shared_mutex m_EntryMutex;
+    std::unordered_map<PipelineState, Entry> m_Entries;
+    /* one map per part, keyed by a state holding only the fields the part depends on */
+    std::mutex m_PartMutex;
+    std::unordered_map<PipelineState, VkPipeline> m_Parts[PART_COUNT];
+
+    static PipelineState GetPartKey(PipelineState const& state, uint32_t part) noexcept;
+    static VkPipeline GetCurrent(Entry const& entry) noexcept;
+    VkResult GetPart(PipelineState const& state, uint32_t part, VkPipeline* pLibrary) noexcept;
+
+public:
+    VkPipeline Get(PipelineState const& state) noexcept;
+    bool IsLibraryEnabled(void) const noexcept;
+    size_t GetPipelineCount(void) noexcept;
+    size_t GetPartCount(void) noexcept;
+
+    PipelineLibrary(Device const& device, PipelineCompiler& compiler, bool libraryEnabled) noexcept;
+    ~PipelineLibrary(void) noexcept;
+};
+}
@@ -0,0 +1,162 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/PipelineCompiler.hpp"
+#include "vks/SpecializationConstants.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* PipelineState struct
+* @brief every input of a graphics pipeline in one fixed size value, hashed and compared as raw bytes
+*
+* Arrays have fixed capacities and unused entries stay zero, so two states describing the same pipeline
+* are identical byte for byte. Shaders use the "main" entry point and share one block of specialization
+* constants, whose values are part of the key, so every specialized variant is its own pipeline. The
+* default state is an opaque triangle list with depth test and dynamic viewport and scissor.
+*/
+struct PipelineState
+{
+    static constexpr uint32_t MAX_STAGES = 5;
+    static constexpr uint32_t MAX_VERTEX_BINDINGS = 4;
+    static constexpr uint32_t MAX_VERTEX_ATTRIBUTES = 16;
+    static constexpr uint32_t MAX_COLOR_ATTACHMENTS = 8;
+    static constexpr uint32_t MAX_DYNAMIC_STATES = 8;
+    static constexpr uint32_t MAX_SPECIALIZATION_CONSTANTS = 8;
+    static constexpr uint32_t MAX_SPECIALIZATION_SIZE = 64;
+
+    VkShaderModule Modules[MAX_STAGES] = {};
+    VkPipelineLayout Layout = VK_NULL_HANDLE;
+    /* VK_NULL_HANDLE for dynamic rendering with ColorFormats, DepthFormat and StencilFormat */
+    VkRenderPass RenderPass = VK_NULL_HANDLE;
+    VkShaderStageFlagBits Stages[MAX_STAGES] = {};
+    uint32_t StageCount = 0;
+
+    VkVertexInputBindingDescription VertexBindings[MAX_VERTEX_BINDINGS] = {};
+    VkVertexInputAttributeDescription VertexAttributes[MAX_VERTEX_ATTRIBUTES] = {};
+    uint32_t VertexBindingCount = 0;
+    uint32_t VertexAttributeCount = 0;
+
+    VkPrimitiveTopology Topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+    VkBool32 PrimitiveRestart = VK_FALSE;
+    VkPolygonMode PolygonMode = VK_POLYGON_MODE_FILL;
+    VkCullModeFlags CullMode = VK_CULL_MODE_BACK_BIT;
+    VkFrontFace FrontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    VkSampleCountFlagBits Samples = VK_SAMPLE_COUNT_1_BIT;
+    VkBool32 DepthTest = VK_TRUE;
+    VkBool32 DepthWrite = VK_TRUE;
+    VkCompareOp DepthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+
+    VkPipelineColorBlendAttachmentState BlendAttachments[MAX_COLOR_ATTACHMENTS] = {};
+    VkFormat ColorFormats[MAX_COLOR_ATTACHMENTS] = {};
+    uint32_t ColorAttachmentCount = 0;
+    VkFormat DepthFormat = VK_FORMAT_UNDEFINED;
+    VkFormat StencilFormat = VK_FORMAT_UNDEFINED;
+    uint32_t Subpass = 0;
+
+    VkDynamicState DynamicStates[MAX_DYNAMIC_STATES] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    uint32_t DynamicStateCount = 2;
+
+    /* applied to every stage, set through SetSpecialization */
+    VkSpecializationMapEntry SpecializationEntries[MAX_SPECIALIZATION_CONSTANTS] = {};
+    uint8_t SpecializationData[MAX_SPECIALIZATION_SIZE] = {};
+    uint32_t SpecializationEntryCount = 0;
+    uint32_t SpecializationDataSize = 0;
+
+    PipelineState& AddStage(VkShaderStageFlagBits stage, VkShaderModule module) noexcept;
+    PipelineState& AddVertexBinding(uint32_t binding, uint32_t stride, VkVertexInputRate inputRate = VK_VERTEX_INPUT_RATE_VERTEX) noexcept;
+    PipelineState& AddVertexAttribute(uint32_t location, uint32_t binding, VkFormat format, uint32_t offset) noexcept;
+    PipelineState& AddColorAttachment(VkFormat format, VkPipelineColorBlendAttachmentState const& blend) noexcept;
+    PipelineState& AddColorAttachment(VkFormat format) noexcept;
+    PipelineState& AddDynamicState(VkDynamicState dynamicState) noexcept;
+
+    template<typename... Ts>
+    PipelineState& SetSpecialization(SpecializationConstants<Ts...> const& constants) noexcept
+    {
+        static_assert(sizeof...(Ts) <= MAX_SPECIALIZATION_CONSTANTS, "too many specialization constants");
+        static_assert(SpecializationConstants<Ts...>::SIZE <= MAX_SPECIALIZATION_SIZE, "specialization data too large");
+        std::fill(std::begin(SpecializationEntries), std::end(SpecializationEntries), VkSpecializationMapEntry{});
+        std::fill(std::begin(SpecializationData), std::end(SpecializationData), uint8_t(0));
+        std::copy(constants.MAP_ENTRIES.begin(), constants.MAP_ENTRIES.end(), SpecializationEntries);
+        std::copy(constants.GetData().begin(), constants.GetData().end(), SpecializationData);
+        SpecializationEntryCount = sizeof...(Ts);
+        SpecializationDataSize = SpecializationConstants<Ts...>::SIZE;
+        return *this;
+    }
+
+    size_t Hash(void) const noexcept;
+    GraphicsPipelineDesc GetDesc(void) const noexcept;
+
+    bool operator==(PipelineState const& other) const noexcept;
+};
+
+/* hashing and comparing the raw bytes is only sound without padding */
+static_assert(std::has_unique_object_representations_v<PipelineState>, "PipelineState must not contain padding");
+
+/**
+* PipelineStateCache class
+* @brief maps pipeline states to pipelines, lookups are lock free and misses create the pipeline once
+*
+* An open addressing table of pointers to immutable entries. Readers probe it without locking, a miss
+* creates the pipeline with the device pipeline cache outside the lock and inserts it under the lock,
+* a racing creation of the same state is destroyed and the first one returned. Failed creations are
+* inserted as VK_NULL_HANDLE so they are not retried on every lookup. A full table is copied
+* into one twice the size and swapped in, old tables are kept until destruction for readers still in them.
+*/
+class PipelineStateCache : public NonCopyable
+{
+    struct Entry
+    {
+        PipelineState State;
+        size_t Hash;
+        VkPipeline Pipeline;
+    };
+
+    struct Table
+    {
+        size_t Mask;
+        std::atomic<Entry*>* pSlots;
+    };
+
+    Device const& m_Device;
+    std::atomic<Table*> m_pTable;
+    /* every table ever published, the current one last */
+    std::vector<Table*> m_Tables;
+    std::vector<Entry*> m_Entries;
+    std::mutex m_InsertMutex;
+
+    static Entry* Probe(Table const* pTable, PipelineState const& state, size_t hash) noexcept;
+    void Insert(Entry* pEntry) noexcept;
+
+public:
+    VkPipeline Get(PipelineState const& state) noexcept;
+    std::optional<VkPipeline> Find(PipelineState const& state) const noexcept;
+    size_t GetPipelineCount(void) noexcept;
+
+    PipelineStateCache(Device const& device, uint32_t initialCapacity = 256) noexcept;
+    ~PipelineStateCache(void) noexcept;
+};
+}
+
+template<>
+struct std::hash<vks::PipelineState>
+{
+    size_t operator()(vks::PipelineState const& state) const noexcept
+    {
+        return state.Hash();
+    }
+};
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <span>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Utils.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+class Queue;
+
+/**
+* GpuFuture class
+* @brief completion of one Queue submit, a value on the queue's timeline semaphore
+*
+* A default constructed future is empty and always ready. Futures stay valid as long as their queue.
+*/
+class GpuFuture
+{
+    friend class Queue;
+
+    Queue* m_pQueue{ nullptr };
+    uint64_t m_Value{ 0 };
+
+    GpuFuture(Queue* pQueue, uint64_t value) noexcept : m_pQueue(pQueue), m_Value(value) {}
+
+public:
+    GpuFuture(void) noexcept = default;
+
+    bool IsReady(void) const noexcept;
+    VkResult Wait(uint64_t timeout = DEFAULT_FENCE_TIMEOUT) const noexcept;
+    void Then(std::function<void(void)> callback) const noexcept;
+
+    VkSemaphore GetSemaphore(void) const noexcept;
+    uint64_t GetValue(void) const noexcept;
+
+    explicit operator bool() const noexcept
+    {
+        return nullptr != m_pQueue;
+    }
+};
+
+/**
+* Queue class
+* @brief asynchronous submission to one VkQueue, tracked by a timeline semaphore
+*
+* Each Submit signals the next value of the queue's timeline semaphore and returns it as a GpuFuture
+* without waiting. Futures can be waited on by later submits to any Queue of the device, polled or waited
+* on by the CPU, or given callbacks that run on the thread calling Poll once the submit has finished.
+* The device must be created with VK_KHR_timeline_semaphore and the timelineSemaphore feature enabled.
+*/
+class Queue : public VulkanEncapsulate<VkQueue>
+{
+    Device const& m_Device;
+    uint32_t m_FamilyIndex;
+
+    VkSemaphore m_Timeline;
+    uint64_t m_NextValue;
+    /* highest value seen signaled, saves querying the semaphore for old futures */
+    uint64_t m_CompletedValue;
+
+    std::multimap<uint64_t, std::function<void(void)>> m_Callbacks;
+    std::mutex m_Mutex;
+
+public:
+    GpuFuture Submit(
+        std::span<const VkCommandBuffer> cmdBuffers,
+        std::span<const GpuFuture> waitFutures = {},
+        std::span<const VkSemaphore> waitSemaphores = {},
+        std::span<const VkPipelineStageFlags> waitStages = {},
+        std::span<const VkSemaphore> signalSemaphores = {}
+    ) noexcept;
+
+    uint64_t GetCompletedValue(void) noexcept;
+    VkResult WaitValue(uint64_t value, uint64_t timeout = DEFAULT_FENCE_TIMEOUT) noexcept;
+    void AddCallback(uint64_t value, std::function<void(void)> callback) noexcept;
+    void Poll(void) noexcept;
+    VkResult WaitIdle(void) noexcept;
+
+    VkSemaphore GetTimeline(void) const noexcept;
+    uint32_t GetFamilyIndex(void) const noexcept;
+
+    Queue(Device const& device, uint32_t familyIndex, uint32_t queueIndex = 0) noexcept;
+    ~Queue(void) noexcept;
+};
+}
@@ -0,0 +1,169 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Allocator.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* ResourceUsage enum
+* @brief how a pass accesses a resource, decides the pipeline stages, access mask and image layout
+*/
+enum class ResourceUsage
+{
+    ColorAttachment,
+    DepthStencilAttachment,
+    DepthStencilRead,
+    InputAttachment,
+    ShaderRead,
+    ShaderWrite,
+    TransferSrc,
+    TransferDst,
+    Present,
+    VertexBuffer,
+    IndexBuffer,
+    UniformBuffer,
+    IndirectBuffer,
+};
+
+/**
+* RenderGraph class
+* @brief orders passes by the resources they read and write and inserts the barriers between them
+*
+* Passes and resources are declared once, Compile culls passes that do not contribute to an output,
+* sorts the rest, computes one merged vkCmdPipelineBarrier per pass and creates the transient images,
+* placing images whose lifetimes do not overlap in the same memory. Execute records the passes and
+* barriers each frame, imported resources such as the swapchain image can be swapped between frames.
+*/
+class RenderGraph : public NonCopyable
+{
+public:
+    using ResourceId = uint32_t;
+    using PassId = uint32_t;
+    using ExecuteFunc = std::function<void(VkCommandBuffer cmdBuffer, RenderGraph const& graph)>;
+
+private:
+    struct Access
+    {
+        ResourceId Resource;
+        ResourceUsage Usage;
+        bool Write;
+    };
+
+    struct Barrier
+    {
+        ResourceId Resource;
+        VkAccessFlags SrcAccess;
+        VkAccessFlags DstAccess;
+        VkImageLayout OldLayout;
+        VkImageLayout NewLayout;
+    };
+
+    /* every barrier recorded before a pass, emitted as a single vkCmdPipelineBarrier */
+    struct BarrierBatch
+    {
+        VkPipelineStageFlags SrcStages{ 0 };
+        VkPipelineStageFlags DstStages{ 0 };
+        std::vector<Barrier> Barriers;
+    };
+
+    struct Pass
+    {
+        std::string Name;
+        ExecuteFunc Execute;
+        std::vector<Access> Accesses;
+        bool SideEffect;
+        BarrierBatch Before;
+    };
+
+    struct Resource
+    {
+        std::string Name;
+        bool IsImage;
+        bool Imported;
+        bool Output;
+
+        VkImage Image{ VK_NULL_HANDLE };
+        VkImageView View{ VK_NULL_HANDLE };
+        VkBuffer Buffer{ VK_NULL_HANDLE };
+        VkImageAspectFlags Aspect{ 0 };
+        VkImageLayout InitialLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+        VkImageLayout FinalLayout{ VK_IMAGE_LAYOUT_UNDEFINED };
+
+        /* transient images only */
+        VkImageCreateInfo CreateInfo{};
+        size_t MemorySlot{ SIZE_MAX };
+        uint32_t FirstUse{ UINT32_MAX };
+        uint32_t LastUse{ 0 };
+    };
+
+    /* memory shared by transient images whose lifetimes do not overlap */
+    struct MemorySlot
+    {
+        VkMemoryRequirements Requirements;
+        std::vector<std::pair<uint32_t, uint32_t>> Lifetimes;
+        Allocation Memory;
+    };
+
+    Device const& m_Device;
+    std::vector<Pass> m_Passes;
+    std::vector<Resource> m_Resources;
+    std::vector<MemorySlot> m_MemorySlots;
+
+    /* compiled state */
+    std::vector<PassId> m_Order;
+    BarrierBatch m_Final;
+
+    void Cull(std::vector<bool>& kept) const noexcept;
+    void Sort(std::vector<bool> const& kept) noexcept;
+    void ComputeBarriers(void) noexcept;
+    void CreateTransients(void) noexcept;
+    void DestroyTransients(void) noexcept;
+    void EmitBarriers(VkCommandBuffer cmdBuffer, BarrierBatch const& batch) const noexcept;
+
+public:
+    ResourceId ImportImage(
+        std::string const& name,
+        VkImage image,
+        VkImageView view,
+        VkImageAspectFlags aspect,
+        VkImageLayout initialLayout,
+        VkImageLayout finalLayout
+    ) noexcept;
+    ResourceId ImportBuffer(std::string const& name, VkBuffer buffer) noexcept;
+    ResourceId CreateImage(
+        std::string const& name,
+        VkFormat format,
+        VkExtent2D extent,
+        VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT
+    ) noexcept;
+    void SetImportedImage(ResourceId id, VkImage image, VkImageView view) noexcept;
+    void SetImportedBuffer(ResourceId id, VkBuffer buffer) noexcept;
+    void MarkOutput(ResourceId id) noexcept;
+
+    PassId AddPass(std::string const& name, ExecuteFunc execute, bool sideEffect = false) noexcept;
+    void Read(PassId pass, ResourceId resource, ResourceUsage usage) noexcept;
+    void Write(PassId pass, ResourceId resource, ResourceUsage usage) noexcept;
+
+    void Compile(void) noexcept;
+    void Execute(VkCommandBuffer cmdBuffer) const noexcept;
+
+    VkImage GetImage(ResourceId id) const noexcept;
+    VkImageView GetView(ResourceId id) const noexcept;
+    VkBuffer GetBuffer(ResourceId id) const noexcept;
+    std::vector<PassId> const& GetOrder(void) const noexcept;
+
+    RenderGraph(Device const& device) noexcept;
+    ~RenderGraph(void) noexcept;
+};
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Framebuffer.hpp"
+#include "vks/Device.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+/**
+* RenderTarget class
+* @brief offscreen stand-in for Swapchain, a ring of device images with the same frame loop API
+*
+* Images are handed out round robin, AcquireNextImage only waits for the fence of the frame slot so the
+* loop runs as fast as the GPU renders, without a window system or vsync. Rendered images are left in
+* VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL for readback, QueuePresent only counts the frame.
+*/
+class RenderTarget : public NonCopyable
+{
+    Device const& m_Device;
+
+    uint32_t m_QueueIndex;
+    VkFormat m_ColorFormat;
+    VkExtent2D m_Extent;
+
+    uint32_t m_ImageIndex;
+    uint32_t m_CurrentFrame;
+    uint32_t m_MaxFramesInFlight;
+    uint64_t m_PresentCount;
+
+    std::vector<vks::FramebufferAttachment*> m_ColorAttachments;
+    std::vector<VkImageView> m_Views;
+    vks::FramebufferAttachment* m_pDepthStencil;
+    std::vector<VkFramebuffer> m_Framebuffers;
+
+    std::vector<VkFence> m_WaitFences;
+
+    VkCommandPool m_CmdPool;
+    std::vector<VkCommandBuffer> m_CmdBuffers;
+
+    VkRenderPass m_RenderPass;
+
+    void Destroy(void) noexcept;
+
+public:
+    static constexpr uint32_t DEFAULT_IMAGE_COUNT = 3;
+    static constexpr uint32_t DEFAULT_MAX_FRAMES_IN_FLIGHT = 2;
+
+    void Recreate(uint32_t& width, uint32_t& height, bool vsync = false) noexcept;
+    VkResult AcquireNextImage(void) noexcept;
+    VkResult QueueSubmit(
+        VkQueue queue,
+        std::vector<VkSemaphore> const& extraWaitSemaphores = {},
+        std::vector<VkPipelineStageFlags> const& extraWaitStages = {}
+        ) const noexcept;
+    VkResult QueuePresent(VkQueue queue) noexcept;
+
+    VkRenderPass const& GetRenderPass(void) const noexcept;
+    uint32_t const& GetQueueIndex(void) const noexcept;
+    uint32_t const& GetCurrentFrame(void) const noexcept;
+    uint32_t const& GetImageIndex(void) const noexcept;
+    uint32_t GetMaxFramesInFlight(void) const noexcept;
+    size_t GetImageCount(void) const noexcept;
+    VkFormat const& GetColorFormat(void) const noexcept;
+    VkExtent2D const& GetExtent(void) const noexcept;
+    std::vector<VkImageView> const& GetImageViews(void) const noexcept;
+    VkImage const& GetImage(uint32_t imageIndex) const noexcept;
+    uint64_t GetPresentCount(void) const noexcept;
+
+    VkCommandBuffer const& GetCommandBuffer(void) const noexcept;
+    VkFramebuffer const& GetFramebuffer(void) const noexcept;
+    VkFence const& GetFence(void) const noexcept;
+
+    RenderTarget(
+        Device const& device,
+        uint32_t& width,
+        uint32_t& height,
+        VkFormat colorFormat = VK_FORMAT_R8G8B8A8_UNORM,
+        uint32_t imageCount = DEFAULT_IMAGE_COUNT,
+        uint32_t maxFramesInFlight = DEFAULT_MAX_FRAMES_IN_FLIGHT
+        ) noexcept;
+    ~RenderTarget(void) noexcept;
+};
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* ResourceTracker class
+* @brief remembers how each buffer and image was last used and emits only the barriers the next use needs
+*
+* Callers state the stages, accesses and layout of the next use, the tracker queues the barrier against
+* the previous use and Flush records every queued barrier with a single vkCmdPipelineBarrier2KHR.
+* Reads after reads need nothing, reads already made visible since the last write need nothing and
+* buffer hazards are merged into global memory barriers. State carries over from one command buffer to
+* the next, so command buffers must be submitted in the order they were recorded with the tracker.
+* Needs VK_KHR_synchronization2 enabled on the device.
+*/
+class ResourceTracker : public NonCopyable
+{
+    struct State
+    {
+        /* last write, or the last layout transition */
+        VkPipelineStageFlags2KHR WriteStages{ 0 };
+        VkAccessFlags2KHR WriteAccess{ 0 };
+        /* stages and accesses the last write was made visible to */
+        VkPipelineStageFlags2KHR VisibleStages{ 0 };
+        VkAccessFlags2KHR VisibleAccess{ 0 };
+        /* stages that read since the last write */
+        VkPipelineStageFlags2KHR ReadStages{ 0 };
+        /* barrier queued for the resource, only valid while PendingBatch is the current batch */
+        uint64_t PendingBatch{ UINT64_MAX };
+        size_t PendingIndex{ 0 };
+        /* the queued barrier is for a write, later uses have to wait for it behind a flush */
+        bool PendingWrite{ false };
+    };
+
+    struct ImageState : State
+    {
+        VkImageLayout Layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+        VkImageAspectFlags Aspect{ VK_IMAGE_ASPECT_COLOR_BIT };
+    };
+
+    Device const& m_Device;
+    VkCommandBuffer m_CmdBuffer;
+
+    std::unordered_map<VkBuffer, State> m_Buffers;
+    std::unordered_map<VkImage, ImageState> m_Images;
+
+    /* barriers queued since the last Flush, m_Batch counts the flushes */
+    uint64_t m_Batch;
+    std::vector<VkMemoryBarrier2KHR> m_MemoryBarriers;
+    std::vector<VkImageMemoryBarrier2KHR> m_ImageBarriers;
+
+    bool IsPending(State const& state) const noexcept;
+    static bool Use(
+        State& state,
+        VkPipelineStageFlags2KHR stages,
+        VkAccessFlags2KHR access,
+        bool transition,
+        VkPipelineStageFlags2KHR& srcStages,
+        VkAccessFlags2KHR& srcAccess
+    ) noexcept;
+
+public:
+    void Begin(VkCommandBuffer cmdBuffer) noexcept;
+    void End(void) noexcept;
+    void Reset(void) noexcept;
+
+    void SetImageState(
+        VkImage image,
+        VkImageAspectFlags aspect,
+        VkImageLayout layout,
+        VkPipelineStageFlags2KHR stages = VK_PIPELINE_STAGE_2_NONE,
+        VkAccessFlags2KHR access = VK_ACCESS_2_NONE
+    ) noexcept;
+    void Forget(VkImage image) noexcept;
+    void Forget(VkBuffer buffer) noexcept;
+
+    void UseBuffer(VkBuffer buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access) noexcept;
+    void UseImage(VkImage image, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access, VkImageLayout layout) noexcept;
+    void Flush(void) noexcept;
+
+    VkImageLayout GetImageLayout(VkImage image) const noexcept;
+
+    ResourceTracker(Device const& device) noexcept;
+    ~ResourceTracker(void) noexcept = default;
+};
+}
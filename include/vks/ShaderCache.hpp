@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* ShaderCache class
+* @brief loads SPIR-V files through memory mapping and shares one module between every load of the same code
+*
+* Files are mapped instead of read, validated for the SPIR-V magic number and word alignment, and hashed,
+* so the same code loaded from several paths or for several pipelines yields one reference counted Shader.
+* With VK_EXT_shader_module_identifier enabled no module is created at load, pipelines are created from the
+* identifier with VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT and GetModule creates the module
+* from the still mapped file only for pipelines the driver cannot find in its cache.
+*/
+class ShaderCache : public NonCopyable
+{
+public:
+    class Shader
+    {
+        friend class ShaderCache;
+
+        uint64_t m_Hash;
+        uint32_t m_RefCount;
+        VkShaderModule m_Module;
+        VkShaderModuleIdentifierEXT m_Identifier;
+
+        /* the mapped SPIR-V, kept until the module is created */
+        void const* m_pCode;
+        size_t m_CodeSize;
+
+    public:
+        uint64_t GetHash(void) const noexcept;
+        bool HasIdentifier(void) const noexcept;
+        VkShaderModuleIdentifierEXT const& GetIdentifier(void) const noexcept;
+    };
+
+private:
+    Device const& m_Device;
+    bool m_IdentifierEnabled;
+
+    std::mutex m_Mutex;
+    /* content hash to shader, and the hash of every path loaded so far */
+    std::unordered_map<uint64_t, Shader*> m_Shaders;
+    std::unordered_map<std::string, uint64_t> m_Paths;
+
+    VkShaderModuleCreateInfo GetModuleCreateInfo(Shader const& shader) const noexcept;
+    void Unmap(Shader& shader) const noexcept;
+
+public:
+    Shader const* Load(std::string const& path) noexcept;
+    void Release(Shader const* pShader) noexcept;
+    VkShaderModule GetModule(Shader const* pShader) noexcept;
+    void FillStage(
+        Shader const* pShader,
+        VkPipelineShaderStageCreateInfo& stage,
+        VkPipelineShaderStageModuleIdentifierCreateInfoEXT& identifierInfo
+    ) noexcept;
+
+    bool IsIdentifierEnabled(void) const noexcept;
+
+    ShaderCache(Device const& device) noexcept;
+    ~ShaderCache(void) noexcept;
+};
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* ShaderReflection struct
+* @brief resources a SPIR-V entry point declares, read from the code loaded with utils::loadShaderCode
+*
+* Descriptor bindings come from the decorated variables of the module, the push constant range from the
+* member offsets of its push constant block and the vertex input from the located vertex shader inputs,
+* which are laid out tightly in location order in binding 0. Unsized arrays are reflected as one
+* descriptor, the layout has to be written by hand for descriptor indexing.
+*/
+struct ShaderReflection
+{
+    struct Binding
+    {
+        uint32_t Set;
+        VkDescriptorSetLayoutBinding Layout;
+    };
+
+    VkShaderStageFlagBits Stage;
+    std::string EntryPoint;
+    std::vector<Binding> Bindings;
+    /* size 0 when the stage has no push constants */
+    VkPushConstantRange PushConstants;
+    /* vertex stage only */
+    std::vector<VkVertexInputAttributeDescription> VertexAttributes;
+    uint32_t VertexStride;
+
+    VkVertexInputBindingDescription GetVertexBinding(void) const noexcept;
+
+    static std::optional<ShaderReflection> Reflect(std::vector<uint32_t> const& code) noexcept;
+};
+
+/**
+* PipelineLayoutCache class
+* @brief creates descriptor set and pipeline layouts from reflected stages, one object per distinct layout
+*
+* Bindings of every stage are merged per set with their stage flags OR'ed, push constant ranges become one
+* range visible to every stage using it. Equal set layouts and pipeline layouts are shared, so pipelines
+* of the same shader interface bind compatible sets, and everything is destroyed with the cache.
+*/
+class PipelineLayoutCache : public NonCopyable
+{
+public:
+    struct Layout
+    {
+        VkPipelineLayout PipelineLayout;
+        /* indexed by set number, sets no stage uses are empty layouts */
+        std::vector<VkDescriptorSetLayout> SetLayouts;
+        VkPushConstantRange PushConstants;
+    };
+
+private:
+    Device const& m_Device;
+
+    std::mutex m_Mutex;
+    /* keyed by the sorted binding, type, count and stage flags of every binding */
+    std::map<std::vector<uint32_t>, VkDescriptorSetLayout> m_SetLayouts;
+    /* keyed by the set layout handles and the push constant range */
+    std::map<std::vector<uint64_t>, Layout> m_Layouts;
+
+    VkDescriptorSetLayout GetSetLayoutLocked(std::vector<VkDescriptorSetLayoutBinding> bindings) noexcept;
+
+public:
+    Layout const& GetLayout(std::vector<ShaderReflection> const& stages) noexcept;
+    VkDescriptorSetLayout GetSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings) noexcept;
+
+    PipelineLayoutCache(Device const& device) noexcept;
+    ~PipelineLayoutCache(void) noexcept;
+};
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/PipelineCompiler.hpp"
+
+namespace vks
+{
+/**
+* SpecializationConstants class
+* @brief specialization constant values with their layout and map entries computed at compile time
+*
+* Constant i of the pack has constant_id i, matching layout(constant_id = i) declared in that order in the
+* shader. Values are packed at their natural alignment, bool is stored as a VkBool32 as Vulkan reads it.
+* Everything is constexpr, e.g. tile sizes picked from the device limits are set at runtime while the map
+* entries stay a compile time table:
+*
+*     SpecializationConstants<uint32_t, uint32_t, bool> constants{ tileX, tileY, true };
+*     constants.Apply(computeDesc.Stage);
+*/
+template<typename... Ts>
+class SpecializationConstants
+{
+    static_assert(sizeof...(Ts) > 0, "SpecializationConstants needs at least one constant");
+    static_assert(((std::is_arithmetic_v<Ts> && (sizeof(Ts) <= 8)) && ...), "specialization constants are scalars");
+
+    template<typename T>
+    using Stored = std::conditional_t<std::is_same_v<T, bool>, VkBool32, T>;
+
+    template<size_t I>
+    using Type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+    static constexpr size_t COUNT = sizeof...(Ts);
+
+    static constexpr std::array<uint32_t, COUNT + 1> Offsets(void) noexcept
+    {
+        constexpr std::array<size_t, COUNT> sizes = { sizeof(Stored<Ts>)... };
+        std::array<uint32_t, COUNT + 1> offsets{};
+        uint32_t offset = 0;
+        for (size_t i = 0; i < COUNT; i++)
+        {
+            /* scalar sizes are their alignments */
+            offset = (uint32_t)((offset + sizes[i] - 1) / sizes[i] * sizes[i]);
+            offsets[i] = offset;
+            offset += (uint32_t)sizes[i];
+        }
+        offsets[COUNT] = offset;
+        return offsets;
+    }
+
+    static constexpr std::array<uint32_t, COUNT + 1> OFFSETS = Offsets();
+
+public:
+    static constexpr uint32_t SIZE = OFFSETS[COUNT];
+
+    static constexpr std::array<VkSpecializationMapEntry, COUNT> MAP_ENTRIES = []<size_t... Is>(std::index_sequence<Is...>)
+    {
+        return std::array<VkSpecializationMapEntry, COUNT>{ VkSpecializationMapEntry{ (uint32_t)Is, OFFSETS[Is], sizeof(Stored<Ts>) }... };
+    }(std::index_sequence_for<Ts...>{});
+
+private:
+    std::array<uint8_t, SIZE> m_Data{};
+
+public:
+    template<size_t I>
+    constexpr void Set(Type<I> value) noexcept
+    {
+        auto bytes = std::bit_cast<std::array<uint8_t, sizeof(Stored<Type<I>>)>>(static_cast<Stored<Type<I>>>(value));
+        for (size_t i = 0; i < bytes.size(); i++)
+        {
+            m_Data[OFFSETS[I] + i] = bytes[i];
+        }
+    }
+
+    template<size_t I>
+    constexpr Type<I> Get(void) const noexcept
+    {
+        std::array<uint8_t, sizeof(Stored<Type<I>>)> bytes{};
+        for (size_t i = 0; i < bytes.size(); i++)
+        {
+            bytes[i] = m_Data[OFFSETS[I] + i];
+        }
+        return static_cast<Type<I>>(std::bit_cast<Stored<Type<I>>>(bytes));
+    }
+
+    constexpr std::array<uint8_t, SIZE> const& GetData(void) const noexcept
+    {
+        return m_Data;
+    }
+
+    /** @brief points into this object, which has to outlive the pipeline creation */
+    VkSpecializationInfo GetInfo(void) const noexcept
+    {
+        return { (uint32_t)COUNT, MAP_ENTRIES.data(), SIZE, m_Data.data() };
+    }
+
+    /** @brief copy the constants into an owning stage description, e.g. for vks::PipelineCompiler */
+    void Apply(ShaderStageDesc& stage) const noexcept
+    {
+        stage.SpecializationEntries.assign(MAP_ENTRIES.begin(), MAP_ENTRIES.end());
+        stage.SpecializationData.assign(m_Data.begin(), m_Data.end());
+    }
+
+    constexpr SpecializationConstants(Ts... values) noexcept
+    {
+        [&]<size_t... Is>(std::index_sequence<Is...>)
+        {
+            (Set<Is>(values), ...);
+        }(std::index_sequence_for<Ts...>{});
+    }
+};
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include "vks/Buffer.hpp"
+#include "vks/Utils.hpp"
+#include "vks/VulkanEncapsulate.hpp"
+
+namespace vks
+{
+class Device;
+
+/**
+* StagingUploader class
+* @brief batches host to device copies through a persistently mapped ring buffer
+*
+* Upload calls copy the source data into the ring and queue a copy command, Submit records every
+* queued copy into one command buffer and submits it without waiting. The returned ticket can be
+* polled with IsComplete or waited on with Wait. The calling thread only blocks when the ring is
+* full and the oldest batch still has to finish before its space can be reused.
+*
+* When created on the transfer queue and the device has a dedicated transfer family, batches end
+* with queue family release barriers and signal a semaphore. Completed batches are handed to the
+* graphics queue by RecordAcquire, which records the matching acquire barriers and returns the
+* semaphores the graphics submit has to wait on. Destinations must be fully overwritten or not yet
+* used on the graphics queue, since the transfer family never acquires them first.
+*/
+class StagingUploader : public NonCopyable
+{
+public:
+    using Ticket = uint64_t;
+
+private:
+    struct BufferCopy
+    {
+        VkBuffer Dst;
+        VkBufferCopy Region;
+    };
+
+    struct ImageCopy
+    {
+        VkImage Dst;
+        VkImageSubresourceRange Range;
+        VkBufferImageCopy Region;
+        VkImageLayout FinalLayout;
+    };
+
+    struct Batch
+    {
+        Ticket Id;
+        VkCommandBuffer CmdBuffer;
+        VkFence Fence;
+        /* ring position one past the last byte this batch reads */
+        VkDeviceSize End;
+        /* ownership transfer only: signaled by the batch, waited by the graphics submit */
+        VkSemaphore Semaphore;
+        std::vector<VkBufferMemoryBarrier> BufferBarriers;
+        std::vector<VkImageMemoryBarrier> ImageBarriers;
+    };
+
+    struct Acquired
+    {
+        VkSemaphore Semaphore;
+        /* fence of the graphics submit waiting on the semaphore */
+        VkFence Fence;
+    };
+
+    Device const& m_Device;
+    Buffer* m_pRing;
+    VkDeviceSize m_Capacity;
+    /* monotonic ring positions, the ring offset is position % capacity */
+    VkDeviceSize m_Head;
+    VkDeviceSize m_Tail;
+
+    /* family copies are recorded for, and the family that consumes the uploads */
+    uint32_t m_QueueFamily;
+    uint32_t m_DstQueueFamily;
+    bool m_OwnershipTransfer;
+    VkQueue m_Queue;
+    VkCommandPool m_CmdPool;
+
+    std::vector<BufferCopy> m_BufferCopies;
+    std::vector<ImageCopy> m_ImageCopies;
+
+    std::deque<Batch> m_InFlight;
+    std::deque<Batch> m_Released;
+    std::vector<Acquired> m_Acquired;
+    std::vector<VkCommandBuffer> m_FreeCmdBuffers;
+    std::vector<VkFence> m_FreeFences;
+    std::vector<VkSemaphore> m_FreeSemaphores;
+    Ticket m_LastSubmitted;
+    Ticket m_LastCompleted;
+
+    std::mutex m_Mutex;
+
+    VkDeviceSize Reserve(VkDeviceSize size, VkDeviceSize alignment) noexcept;
+    Ticket SubmitLocked(void) noexcept;
+    void Retire(void) noexcept;
+    void WaitOldest(void) noexcept;
+
+public:
+    static constexpr VkDeviceSize DEFAULT_CAPACITY = 32ull * 1024 * 1024;
+
+    bool Upload(Buffer const& dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset = 0) noexcept;
+    bool UploadImage(
+        VkImage dst,
+        VkImageSubresourceRange const& range,
+        VkBufferImageCopy region,
+        const void* data,
+        VkDeviceSize size,
+        VkImageLayout finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+    ) noexcept;
+
+    Ticket Submit(void) noexcept;
+    bool IsComplete(Ticket ticket) noexcept;
+    VkResult Wait(Ticket ticket, uint64_t timeout = DEFAULT_FENCE_TIMEOUT) noexcept;
+    void RecordAcquire(
+        VkCommandBuffer cmdBuffer,
+        VkFence submitFence,
+        std::vector<VkSemaphore>& waitSemaphores,
+        std::vector<VkPipelineStageFlags>& waitStages
+    ) noexcept;
+
+    StagingUploader(Device const& device, VkDeviceSize capacity = DEFAULT_CAPACITY, bool transferQueue = false) noexcept;
+    ~StagingUploader(void) noexcept;
+};
+}
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <deque>
+#include <vector>
+
 #include <vulkan/vulkan.h>
 
 #include "Framebuffer.hpp"
@@ -11,6 +14,17 @@ namespace vks
 {
 class Swapchain : public VulkanEncapsulate<VkSwapchainKHR>
 {
+    /* resources replaced by Recreate, destroyed once every frame that may use them has finished */
+    struct Retired
+    {
+        uint64_t Frame;
+        VkSwapchainKHR Swapchain;
+        std::vector<VkImageView> Views;
+        std::vector<VkFramebuffer> Framebuffers;
+        std::vector<VkSemaphore> RenderDoneSemaphores;
+        vks::FramebufferAttachment* pDepthStencil;
+    };
+
     Instance const& m_Instance;
     Device const& m_Device;
     VkSurfaceKHR m_Surface;
@@ -18,9 +32,12 @@ class Swapchain : public VulkanEncapsulate<VkSwapchainKHR>
     uint32_t m_QueueIndex;
     VkFormat m_ColorFormat;
     VkColorSpaceKHR m_ColorSpace;
+    VkExtent2D m_Extent;
 
     uint32_t m_ImageIndex;
+    /* frame slot in [0, m_MaxFramesInFlight), independent of the image index */
     uint32_t m_CurrentFrame;
+    uint32_t m_MaxFramesInFlight;
 
     std::vector<VkImage> m_Images;
     std::vector<VkImageView> m_Views;
@@ -28,30 +45,63 @@ class Swapchain : public VulkanEncapsulate<VkSwapchainKHR>
     vks::FramebufferAttachment* m_pDepthStencil;
     std::vector<VkFramebuffer> m_Framebuffers;
 
+    /* per frame in flight */
     std::vector<VkSemaphore> m_PresentDoneSemaphore;
-    std::vector<VkSemaphore> m_RenderDoneSemaphore;
     std::vector<VkFence> m_WaitFences;
+    /* per swapchain image, a present may still wait on it until the image is acquired again */
+    std::vector<VkSemaphore> m_RenderDoneSemaphore;
 
     VkCommandPool m_CmdPool;
     std::vector<VkCommandBuffer> m_CmdBuffers;
 
+    /* without a render pass and framebuffers, views go straight to vkCmdBeginRenderingKHR */
+    bool m_DynamicRendering;
     VkRenderPass m_RenderPass;
 
+    /* number of the last acquired frame, the frame each fence was last submitted for, and the last finished frame */
+    uint64_t m_FrameNumber;
+    std::vector<uint64_t> m_FenceFrames;
+    uint64_t m_CompletedFrame;
+    std::deque<Retired> m_Retired;
+
+    void CreateRenderPass(void) noexcept;
+    void DestroyRetired(Retired& retired) noexcept;
+    void CollectRetired(void) noexcept;
+
 public:
+    static constexpr uint32_t DEFAULT_MAX_FRAMES_IN_FLIGHT = 2;
+
     void Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept;
     VkResult AcquireNextImage(void) noexcept;
-    VkResult QueueSubmit(VkQueue queue) const noexcept;
-    VkResult QueuePresent(VkQueue queue) const noexcept;
+    VkResult QueueSubmit(
+        VkQueue queue,
+        std::vector<VkSemaphore> const& extraWaitSemaphores = {},
+        std::vector<VkPipelineStageFlags> const& extraWaitStages = {}
+        ) const noexcept;
+    VkResult QueuePresent(VkQueue queue, uint64_t presentId = 0) const noexcept;
+
+    void BeginRendering(
+        VkCommandBuffer cmdBuffer,
+        VkClearColorValue clearColor = {},
+        VkClearDepthStencilValue clearDepthStencil = { 1.0f, 0 }
+        ) const noexcept;
+    void EndRendering(VkCommandBuffer cmdBuffer) const noexcept;
+    VkPipelineRenderingCreateInfoKHR GetPipelineRenderingCreateInfo(void) const noexcept;
+    bool IsDynamicRendering(void) const noexcept;
 
     VkRenderPass const& GetRenderPass(void) const noexcept;
     uint32_t const& GetQueueIndex(void) const noexcept;
     uint32_t const& GetCurrentFrame(void) const noexcept;
+    uint32_t const& GetImageIndex(void) const noexcept;
+    uint32_t GetMaxFramesInFlight(void) const noexcept;
     size_t GetImageCount(void) const noexcept;
     VkFormat const& GetColorFormat(void) const noexcept;
+    VkExtent2D const& GetExtent(void) const noexcept;
     std::vector<VkImageView> const& GetImageViews(void) const noexcept;
 
     VkCommandBuffer const& GetCommandBuffer(void) const noexcept;
     VkFramebuffer const& GetFramebuffer(void) const noexcept;
+    VkFence const& GetFence(void) const noexcept;
 
     Swapchain(
         Instance const& instance,
@@ -59,7 +109,9 @@ public:
         VkSurfaceKHR surface,
         uint32_t& width,
         uint32_t& height,
-        bool vsync
+        bool vsync,
+        uint32_t maxFramesInFlight = DEFAULT_MAX_FRAMES_IN_FLIGHT,
+        bool dynamicRendering = false
         );
     ~Swapchain(void) noexcept;
 };
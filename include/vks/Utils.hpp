@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <glm/glm.hpp>
 
@@ -32,6 +33,8 @@ namespace utils
 std::string statusString(VkResult result) noexcept;
 void exitFatal(const std::string& message, int32_t exitCode);
 void exitFatal(const std::string& message, VkResult resultCode);
+std::vector<uint32_t> loadShaderCode(const char* fileName);
+VkShaderModule loadShader(std::vector<uint32_t> const& code, VkDevice device);
 VkShaderModule loadShader(const char* fileName, VkDevice device);
 }
 }
@@ -0,0 +1,390 @@
+#include <algorithm>
+#include <bit>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/Allocator.hpp"
+
+namespace vks
+{
+Allocator::Allocator(Device const& device, VkDeviceSize preferredBlockSize) noexcept
+    : m_Device(device), m_PreferredBlockSize(std::bit_floor(preferredBlockSize)), m_HeapStats{}
+{
+}
+
+Allocator::~Allocator(void) noexcept
+{
+    for (auto& pool : m_Pools)
+    {
+        for (auto& pBlock : pool.Blocks)
+        {
+            if (0 != pBlock->Used)
+            {
+                spdlog::warn("Memory block of type {} destroyed with {} bytes still allocated", pool.MemoryType, pBlock->Used);
+            }
+            FreeMemory(*pBlock);
+        }
+    }
+}
+
+HeapStats& Allocator::GetTypeHeapStats(uint32_t memoryType) noexcept
+{
+    return m_HeapStats[m_Device.GetMemoryProperties().memoryTypes[memoryType].heapIndex];
+}
+
+/**
+* Find the pool for a memory type and resource kind, creating it on first use
+*
+* @param memoryType index of the memory type the pool allocates from
+* @param linear true for buffers and linear tiling images, false for optimal tiling images
+* @param flags VkMemoryAllocateFlags every block of the pool is allocated with
+*/
+Allocator::Pool& Allocator::GetPool(uint32_t memoryType, bool linear, VkMemoryAllocateFlags flags) noexcept
+{
+    /* linear and non-linear resources can only share a block when they can share a page */
+    if (m_Device.GetProperties().limits.bufferImageGranularity <= 1)
+    {
+        linear = true;
+    }
+
+    for (auto& pool : m_Pools)
+    {
+        if ((pool.MemoryType == memoryType) && (pool.Linear == linear) && (pool.Flags == flags))
+        {
+            return pool;
+        }
+    }
+
+    /* keep blocks small on small heaps so one block does not take a large share of the heap */
+    VkPhysicalDeviceMemoryProperties const& memProps = m_Device.GetMemoryProperties();
+    VkDeviceSize heapSize = memProps.memoryHeaps[memProps.memoryTypes[memoryType].heapIndex].size;
+    VkDeviceSize blockSize = std::min(m_PreferredBlockSize, std::bit_floor(heapSize / 8));
+    blockSize = std::max(blockSize, VkDeviceSize(1) << (MIN_ORDER + 1));
+
+    Pool pool{};
+    pool.MemoryType = memoryType;
+    pool.Linear = linear;
+    pool.Flags = flags;
+    pool.MaxOrder = static_cast<uint32_t>(std::bit_width(blockSize)) - 1;
+    m_Pools.push_back(std::move(pool));
+    return m_Pools.back();
+}
+
+/**
+* Take a free range of 2^order bytes from a block, splitting larger ranges as needed
+*
+* @return false if the block has no free range large enough
+*/
+bool Allocator::TakeRange(Block& block, uint32_t order, VkDeviceSize& offset) noexcept
+{
+    uint32_t k = order;
+    while ((k < block.FreeLists.size()) && block.FreeLists[k].empty())
+    {
+        k++;
+    }
+    if (k == block.FreeLists.size())
+    {
+        return false;
+    }
+
+    offset = *block.FreeLists[k].begin();
+    block.FreeLists[k].erase(block.FreeLists[k].begin());
+
+    /* return the upper halves of every split to the free lists */
+    while (k > order)
+    {
+        k--;
+        block.FreeLists[k].insert(offset + (VkDeviceSize(1) << k));
+    }
+
+    block.Used += VkDeviceSize(1) << order;
+    return true;
+}
+
+/**
+* Return a range of 2^order bytes to a block, merging it with its buddy as long as the buddy is free
+*/
+void Allocator::ReturnRange(Block& block, uint32_t order, VkDeviceSize offset) noexcept
+{
+    block.Used -= VkDeviceSize(1) << order;
+
+    while (order + 1 < block.FreeLists.size())
+    {
+        VkDeviceSize buddy = offset ^ (VkDeviceSize(1) << order);
+        auto it = block.FreeLists[order].find(buddy);
+        if (block.FreeLists[order].end() == it)
+        {
+            break;
+        }
+        block.FreeLists[order].erase(it);
+        offset = std::min(offset, buddy);
+        order++;
+    }
+
+    block.FreeLists[order].insert(offset);
+}
+
+VkResult Allocator::AllocateMemory(uint32_t memoryType, VkDeviceSize size, VkMemoryAllocateFlags flags, Block& block) noexcept
+{
+    VkMemoryAllocateInfo memAlloc = vks::inits::memoryAllocateInfo();
+    memAlloc.allocationSize = size;
+    memAlloc.memoryTypeIndex = memoryType;
+
+    VkMemoryAllocateFlagsInfoKHR allocFlagsInfo{};
+    if (flags)
+    {
+        allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
+        allocFlagsInfo.flags = flags;
+        memAlloc.pNext = &allocFlagsInfo;
+    }
+
+    VkResult result = vkAllocateMemory(m_Device, &memAlloc, nullptr, &block.Memory);
+    if (VK_SUCCESS != result)
+    {
+        spdlog::error("Failed to allocate {} bytes of memory type {}: {}", size, memoryType, vks::utils::statusString(result));
+        return result;
+    }
+
+    block.Size = size;
+    block.MemoryType = memoryType;
+
+    HeapStats& stats = GetTypeHeapStats(memoryType);
+    stats.BlockCount++;
+    stats.BlockBytes += size;
+    return VK_SUCCESS;
+}
+
+void Allocator::FreeMemory(Block& block) noexcept
+{
+    if (block.pMapped)
+    {
+        vkUnmapMemory(m_Device, block.Memory);
+        block.pMapped = nullptr;
+        block.MapCount = 0;
+    }
+    vkFreeMemory(m_Device, block.Memory, nullptr);
+    block.Memory = VK_NULL_HANDLE;
+
+    HeapStats& stats = GetTypeHeapStats(block.MemoryType);
+    stats.BlockCount--;
+    stats.BlockBytes -= block.Size;
+}
+
+/**
+* Allocate a range of device memory satisfying the given requirements
+* Memory types are tried from the best to the worst fit for the usage, a type whose heap is
+* exhausted falls through to the next one
+*
+* @param memReqs requirements of the resource, from vkGet*MemoryRequirements
+* @param usage how the resource is accessed
+* @param linear true for buffers and linear tiling images, false for optimal tiling images
+* @param allocation filled with the resulting allocation on success
+* @param allocateFlags VkMemoryAllocateFlags the memory must be allocated with, e.g. device address
+*
+* @return VK_SUCCESS, VK_ERROR_FEATURE_NOT_PRESENT if no memory type matches, or the vkAllocateMemory error
+*/
+VkResult Allocator::Allocate(
+    VkMemoryRequirements const& memReqs,
+    MemoryUsage usage,
+    bool linear,
+    Allocation& allocation,
+    VkMemoryAllocateFlags allocateFlags
+) noexcept
+{
+    std::vector<uint32_t> memoryTypes = m_Device.RankMemoryTypes(memReqs.memoryTypeBits, usage);
+    if (memoryTypes.empty())
+    {
+        spdlog::error("No memory type in {:#x} suits usage {}", memReqs.memoryTypeBits, static_cast<int>(usage));
+        return VK_ERROR_FEATURE_NOT_PRESENT;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    VkResult result = VK_ERROR_FEATURE_NOT_PRESENT;
+    for (uint32_t memoryType : memoryTypes)
+    {
+        result = AllocateOfType(memReqs, memoryType, linear, allocation, allocateFlags);
+        if ((VK_ERROR_OUT_OF_DEVICE_MEMORY != result) && (VK_ERROR_OUT_OF_HOST_MEMORY != result))
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+VkResult Allocator::AllocateOfType(
+    VkMemoryRequirements const& memReqs,
+    uint32_t memoryType,
+    bool linear,
+    Allocation& allocation,
+    VkMemoryAllocateFlags allocateFlags
+) noexcept
+{
+    Pool& pool = GetPool(memoryType, linear, allocateFlags);
+    size_t poolIndex = std::distance(m_Pools.data(), &pool);
+
+    /* buddy ranges are aligned to their own size, so rounding up to the alignment is enough */
+    VkDeviceSize required = std::max(memReqs.size, memReqs.alignment);
+    uint32_t order = std::max(MIN_ORDER, static_cast<uint32_t>(std::bit_width(required - 1)));
+
+    /* anything larger than half a block gets its own memory */
+    if (order >= pool.MaxOrder)
+    {
+        Block* pBlock = new Block{};
+        VkResult result = AllocateMemory(pool.MemoryType, memReqs.size, allocateFlags, *pBlock);
+        if (VK_SUCCESS != result)
+        {
+            delete pBlock;
+            return result;
+        }
+        pBlock->PoolIndex = poolIndex;
+        pBlock->Dedicated = true;
+        pBlock->Used = memReqs.size;
+
+        allocation.m_pBlock = pBlock;
+        allocation.m_Order = 0;
+        allocation.Memory = pBlock->Memory;
+        allocation.Offset = 0;
+        allocation.Size = memReqs.size;
+        allocation.MemoryType = pool.MemoryType;
+
+        HeapStats& stats = GetTypeHeapStats(pool.MemoryType);
+        stats.AllocationCount++;
+        stats.AllocationBytes += allocation.Size;
+        return VK_SUCCESS;
+    }
+
+    VkDeviceSize offset = 0;
+    Block* pBlock = nullptr;
+    for (auto& pCandidate : pool.Blocks)
+    {
+        if (TakeRange(*pCandidate, order, offset))
+        {
+            pBlock = pCandidate.get();
+            break;
+        }
+    }
+
+    if (!pBlock)
+    {
+        auto pNewBlock = std::make_unique<Block>();
+        VkResult result = AllocateMemory(pool.MemoryType, VkDeviceSize(1) << pool.MaxOrder, allocateFlags, *pNewBlock);
+        if (VK_SUCCESS != result)
+        {
+            return result;
+        }
+        pNewBlock->PoolIndex = poolIndex;
+        pNewBlock->FreeLists.resize(pool.MaxOrder + 1);
+        pNewBlock->FreeLists[pool.MaxOrder].insert(0);
+
+        pBlock = pNewBlock.get();
+        pool.Blocks.push_back(std::move(pNewBlock));
+        TakeRange(*pBlock, order, offset);
+    }
+
+    allocation.m_pBlock = pBlock;
+    allocation.m_Order = order;
+    allocation.Memory = pBlock->Memory;
+    allocation.Offset = offset;
+    allocation.Size = VkDeviceSize(1) << order;
+    allocation.MemoryType = pool.MemoryType;
+
+    HeapStats& stats = GetTypeHeapStats(pool.MemoryType);
+    stats.AllocationCount++;
+    stats.AllocationBytes += allocation.Size;
+    return VK_SUCCESS;
+}
+
+/**
+* Return an allocation to its block, the allocation is reset to empty afterwards
+* Empty blocks are released as long as their pool keeps at least one block
+*/
+void Allocator::Free(Allocation& allocation) noexcept
+{
+    if (!allocation.m_pBlock)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    HeapStats& stats = GetTypeHeapStats(allocation.MemoryType);
+    stats.AllocationCount--;
+    stats.AllocationBytes -= allocation.Size;
+
+    Block* pBlock = static_cast<Block*>(allocation.m_pBlock);
+    if (pBlock->Dedicated)
+    {
+        FreeMemory(*pBlock);
+        delete pBlock;
+    }
+    else
+    {
+        ReturnRange(*pBlock, allocation.m_Order, allocation.Offset);
+
+        Pool& pool = m_Pools[pBlock->PoolIndex];
+        if ((0 == pBlock->Used) && (pool.Blocks.size() > 1))
+        {
+            auto it = std::find_if(pool.Blocks.begin(), pool.Blocks.end(),
+                [pBlock](std::unique_ptr<Block> const& p) { return p.get() == pBlock; });
+            FreeMemory(*pBlock);
+            pool.Blocks.erase(it);
+        }
+    }
+
+    allocation = Allocation{};
+}
+
+/**
+* Map the memory behind an allocation
+* The whole block is mapped once and shared by every allocation in it, mappings are reference counted
+*
+* @param ppData receives the host address of the allocation's first byte
+*/
+VkResult Allocator::Map(Allocation const& allocation, void** ppData) noexcept
+{
+    assert(allocation.m_pBlock);
+    Block& block = *static_cast<Block*>(allocation.m_pBlock);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (0 == block.MapCount)
+    {
+        VkResult result = vkMapMemory(m_Device, block.Memory, 0, VK_WHOLE_SIZE, 0, &block.pMapped);
+        if (VK_SUCCESS != result)
+        {
+            return result;
+        }
+    }
+    block.MapCount++;
+
+    *ppData = static_cast<uint8_t*>(block.pMapped) + allocation.Offset;
+    return VK_SUCCESS;
+}
+
+void Allocator::Unmap(Allocation const& allocation) noexcept
+{
+    assert(allocation.m_pBlock);
+    Block& block = *static_cast<Block*>(allocation.m_pBlock);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    assert(block.MapCount > 0);
+    if (0 == --block.MapCount)
+    {
+        vkUnmapMemory(m_Device, block.Memory);
+        block.pMapped = nullptr;
+    }
+}
+
+/**
+* Snapshot of the block and allocation counters of every heap, Usage and Budget are left to Device
+*/
+std::array<HeapStats, VK_MAX_MEMORY_HEAPS> Allocator::GetHeapStats(void) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_HeapStats;
+}
+}
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include "vks/Inits.hpp"
 #include "vks/Utils.hpp"
 #include "vks/Device.hpp"
@@ -9,11 +11,12 @@ namespace vks
 Buffer::Buffer(
 	Device const& device,
 	VkBufferUsageFlags usageFlags,
-	VkMemoryPropertyFlags memoryPropertyFlags,
+	MemoryUsage usage,
 	VkDeviceSize size,
-	void* data
+	void* data,
+	bool persistent
 ) noexcept
-	: m_Device(device), m_Size(size), m_pMapped(nullptr)
+	: m_Device(device), m_Size(size), m_pMapped(nullptr), m_Persistent(false), m_DirtyBegin(VK_WHOLE_SIZE), m_DirtyEnd(0)
 {
 	VkBufferCreateInfo bufferCreateInfo = vks::inits::bufferCreateInfo(0, usageFlags, size);
 	VK_CHK(vkCreateBuffer(device, &bufferCreateInfo, nullptr, &m_Handle));
@@ -21,32 +24,41 @@ Buffer::Buffer(
 	VkMemoryRequirements memReqs;
 	vkGetBufferMemoryRequirements(device, m_Handle, &memReqs);
 
-	VkMemoryAllocateInfo memAlloc = vks::inits::memoryAllocateInfo();
-	memAlloc.allocationSize = memReqs.size;
-	memAlloc.memoryTypeIndex = device.GetMemoryType(memReqs.memoryTypeBits, memoryPropertyFlags).value();
-
-	VkMemoryAllocateFlagsInfoKHR allocFlagsInfo{};
+	VkMemoryAllocateFlags allocFlags = 0;
 	if (usageFlags & VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT)
 	{
-		allocFlagsInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_FLAGS_INFO_KHR;
-		allocFlagsInfo.flags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
-		memAlloc.pNext = &allocFlagsInfo;
+		allocFlags = VK_MEMORY_ALLOCATE_DEVICE_ADDRESS_BIT_KHR;
+	}
+	VK_CHK(device.GetAllocator().Allocate(memReqs, usage, true, m_Allocation, allocFlags));
+	m_Coherent = device.GetMemoryProperties().memoryTypes[m_Allocation.MemoryType].propertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+	if (persistent)
+	{
+		VK_CHK(Map());
+		m_Persistent = true;
 	}
-	VK_CHK(vkAllocateMemory(device, &memAlloc, nullptr, &m_Memory));
 
 	if (data != nullptr)
 	{
-		VK_CHK(Map(size));
+		if (!m_Persistent)
+		{
+			VK_CHK(Map(size));
+		}
 		CopyData(data, size);
-		/* manual flush when COHERENT bit is not requested */
-		if (!(memoryPropertyFlags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT))
+		/* manual flush when the chosen memory type is not HOST_COHERENT */
+		if (!m_Coherent)
 		{
-			VK_CHK(Flush(size));
+			VK_CHK(Flush());
 		}
-		Unmap();
+		if (!m_Persistent)
+		{
+			Unmap();
+		}
+		m_DirtyBegin = VK_WHOLE_SIZE;
+		m_DirtyEnd = 0;
 	}
 
-	VK_CHK(vkBindBufferMemory(device, m_Handle, m_Memory, 0));
+	VK_CHK(vkBindBufferMemory(device, m_Handle, m_Allocation.Memory, m_Allocation.Offset));
 }
 
 Buffer::~Buffer(void) noexcept
@@ -55,35 +67,87 @@ Buffer::~Buffer(void) noexcept
 	{
 		vkDestroyBuffer(m_Device, m_Handle, nullptr);
 	}
-	if (m_Memory)
+	if (m_pMapped)
 	{
-		vkFreeMemory(m_Device, m_Memory, nullptr);
+		m_Device.GetAllocator().Unmap(m_Allocation);
 	}
+	m_Device.GetAllocator().Free(m_Allocation);
 }
 
-VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) const noexcept
+/**
+* Build the mapped range of a byte range of this buffer for flushing or invalidating
+*/
+VkMappedMemoryRange Buffer::GetMappedRange(VkDeviceSize size, VkDeviceSize offset) const noexcept
 {
+	/*
+	 * the memory may be shared with other buffers, never reach past the end of this allocation
+	 * ranges must start and end on nonCoherentAtomSize within the memory object,
+	 * allocations always start on an atom and end on an atom or at the end of the memory object
+	 */
+	VkDeviceSize atomSize = m_Device.GetProperties().limits.nonCoherentAtomSize;
+	VkDeviceSize allocEnd = m_Allocation.Offset + m_Allocation.Size;
+	VkDeviceSize begin = m_Allocation.Offset + offset;
+	VkDeviceSize end = (VK_WHOLE_SIZE == size) ? allocEnd : begin + size;
+	begin = begin / atomSize * atomSize;
+	end = std::min((end + atomSize - 1) / atomSize * atomSize, allocEnd);
+
 	VkMappedMemoryRange mappedRange = vks::inits::mappedMemoryRange();
-	mappedRange.memory = m_Memory;
-	mappedRange.offset = offset;
-	mappedRange.size = size;
+	mappedRange.memory = m_Allocation.Memory;
+	mappedRange.offset = begin;
+	mappedRange.size = end - begin;
+	return mappedRange;
+}
+
+VkResult Buffer::Flush(VkDeviceSize size, VkDeviceSize offset) const noexcept
+{
+	VkMappedMemoryRange mappedRange = GetMappedRange(size, offset);
 	return vkFlushMappedMemoryRanges(m_Device, 1, &mappedRange);
 }
 
+/**
+* Make GPU writes visible to the mapping, needed before reading memory that is not HOST_COHERENT
+*/
+VkResult Buffer::Invalidate(VkDeviceSize size, VkDeviceSize offset) const noexcept
+{
+	if (m_Coherent)
+	{
+		return VK_SUCCESS;
+	}
+	VkMappedMemoryRange mappedRange = GetMappedRange(size, offset);
+	return vkInvalidateMappedMemoryRanges(m_Device, 1, &mappedRange);
+}
+
 VkResult Buffer::Map(VkDeviceSize size, VkDeviceSize offset, VkMemoryMapFlags flags) noexcept
 {
+	if (m_Persistent)
+	{
+		return VK_SUCCESS;
+	}
 	if (m_pMapped)
 	{
 		spdlog::warn("Map a mapped buffer");
 	}
-	return vkMapMemory(m_Device, m_Memory, offset, size, flags, &m_pMapped);
+	/* the allocator maps whole memory blocks once and shares the mapping, size and flags are not needed */
+	(void)size;
+	(void)flags;
+	void* pData;
+	VkResult result = m_Device.GetAllocator().Map(m_Allocation, &pData);
+	if (VK_SUCCESS == result)
+	{
+		m_pMapped = static_cast<uint8_t*>(pData) + offset;
+	}
+	return result;
 }
 
 void Buffer::Unmap(void) noexcept
 {
+	if (m_Persistent)
+	{
+		return;
+	}
 	if (m_pMapped)
 	{
-		vkUnmapMemory(m_Device, m_Memory);
+		m_Device.GetAllocator().Unmap(m_Allocation);
 		m_pMapped = nullptr;
 	}
 	else
@@ -92,32 +156,75 @@ void Buffer::Unmap(void) noexcept
 	}
 }
 
-void Buffer::CopyData(const void* data, size_t size) noexcept
+void Buffer::CopyData(const void* data, size_t size, VkDeviceSize offset) noexcept
 {
 	assert(m_pMapped);
-	memcpy(m_pMapped, data, size);
+	memcpy(static_cast<uint8_t*>(m_pMapped) + offset, data, size);
+	if (m_Persistent)
+	{
+		MarkDirty(offset, size);
+	}
+}
+
+/**
+* Record a byte range written through the persistent mapping, the range is flushed by the next FlushDirty
+*/
+void Buffer::MarkDirty(VkDeviceSize offset, VkDeviceSize size) noexcept
+{
+	m_DirtyBegin = std::min(m_DirtyBegin, offset);
+	m_DirtyEnd = std::max(m_DirtyEnd, offset + size);
+}
+
+/**
+* Flush the union of all ranges marked dirty since the last call, a no-op on HOST_COHERENT memory
+*/
+VkResult Buffer::FlushDirty(void) noexcept
+{
+	if (m_DirtyBegin >= m_DirtyEnd)
+	{
+		return VK_SUCCESS;
+	}
+
+	VkResult result = VK_SUCCESS;
+	if (!m_Coherent)
+	{
+		result = Flush(m_DirtyEnd - m_DirtyBegin, m_DirtyBegin);
+	}
+	m_DirtyBegin = VK_WHOLE_SIZE;
+	m_DirtyEnd = 0;
+	return result;
 }
 
 void Buffer::CopyFrom(vks::Buffer& src, std::optional<VkBufferCopy> bufferCopy) const noexcept
 {
-	VkCommandBufferAllocateInfo cmdBufAllocateInfo =
-		vks::inits::commandBufferAllocateInfo(m_Device.m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
-	VkCommandBuffer copyCmd;
-	VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, &copyCmd));
+	VkCommandBuffer copyCmd = m_Device.BeginOneTimeCommandBuffer();
 
 	VkQueue queue;
 	vkGetDeviceQueue(m_Device, m_Device.QueueIndex.Graphics, 0, &queue);
 
-	VkCommandBufferBeginInfo cmdBufInfo = vks::inits::commandBufferBeginInfo();
-	VK_CHK(vkBeginCommandBuffer(copyCmd, &cmdBufInfo));
-
 	VkBufferCopy tmpBufferCopy = bufferCopy.value_or(VkBufferCopy{ .size = src.m_Size });
 	vkCmdCopyBuffer(copyCmd, src.m_Handle, m_Handle, 1, &tmpBufferCopy);
 
-	VK_CHK(vkEndCommandBuffer(copyCmd));
+	m_Device.FlushOneTimeCommandBuffer(copyCmd, queue);
+}
+
+Allocation const& Buffer::GetAllocation(void) const noexcept
+{
+	return m_Allocation;
+}
+
+VkDeviceSize Buffer::GetSize(void) const noexcept
+{
+	return m_Size;
+}
 
-	m_Device.SubmitCommandBuffer(copyCmd, queue);
+void* Buffer::GetMappedData(void) const noexcept
+{
+	return m_pMapped;
+}
 
-	vkFreeCommandBuffers(m_Device, m_Device.m_CmdPool, 1, &copyCmd);
+bool Buffer::IsPersistent(void) const noexcept
+{
+	return m_Persistent;
 }
 }
\ No newline at end of file
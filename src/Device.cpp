@@ -1,4 +1,9 @@
+#include <algorithm>
 #include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 
 #include "vks/Utils.hpp"
 #include "vks/Inits.hpp"
@@ -7,14 +12,27 @@
 
 namespace vks
 {
+/* instance level, VK_KHR_get_physical_device_properties2 is needed for memory budget queries on Vulkan 1.0 */
+static PFN_vkGetPhysicalDeviceMemoryProperties2KHR vkGetPhysicalDeviceMemoryProperties2KHR = nullptr;
+
+/**
+* Load the instance level functions Device relies on, called by Instance once it is created
+*/
+void Device::LoadInstanceFunctions(VkInstance instance) noexcept
+{
+    vkGetPhysicalDeviceMemoryProperties2KHR = reinterpret_cast<PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+        vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR"));
+}
+
 Device::Device(
     VkPhysicalDevice gpu,
     VkPhysicalDeviceFeatures enabledFeatures,
     std::vector<const char*> enabledExtensions,
     void* pNextChain,
-    VkQueueFlags requestedQueueTypes
+    VkQueueFlags requestedQueueTypes,
+    std::string pipelineCachePath
 ) noexcept
-    : m_PhysicalDevice(gpu)
+    : m_PhysicalDevice(gpu), m_PipelineCache(VK_NULL_HANDLE), m_PipelineCachePath(std::move(pipelineCachePath))
 {
     vkGetPhysicalDeviceProperties(gpu, &m_Properties);
     vkGetPhysicalDeviceFeatures(gpu, &m_Features);
@@ -82,7 +100,17 @@ Device::Device(
     }
 
     std::vector<const char *> exts(enabledExtensions);
-    exts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    /* headless devices, e.g. on a render farm, may not expose it, vks::RenderTarget does not need it */
+    if (ExtensionSupported(VK_KHR_SWAPCHAIN_EXTENSION_NAME))
+    {
+        exts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
+
+    m_MemoryBudget = (nullptr != vkGetPhysicalDeviceMemoryProperties2KHR) && ExtensionSupported(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    if (m_MemoryBudget)
+    {
+        exts.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+    }
 
     VkDeviceCreateInfo deviceCreateInfo = {};
     deviceCreateInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -120,15 +148,43 @@ Device::Device(
 
     VK_CHK(vkCreateDevice(m_PhysicalDevice, &deviceCreateInfo, nullptr, &m_Handle));
 
-    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-    cmdPoolInfo.queueFamilyIndex = QueueIndex.Graphics;
-    VK_CHK(vkCreateCommandPool(m_Handle, &cmdPoolInfo, nullptr, &m_CmdPool));
+    /* enough for the usual one-shot paths, more are created on demand and kept */
+    constexpr uint32_t preallocated = 4;
+    for (uint32_t i = 0; i < preallocated; i++)
+    {
+        m_FreeOneTimeCommands.push_back(CreateOneTimeCommands());
+    }
+    VkFenceCreateInfo fenceInfo = vks::inits::fenceCreateInfo(VK_FLAGS_NONE);
+    m_FreeFences.resize(preallocated);
+    for (auto& fence : m_FreeFences)
+    {
+        VK_CHK(vkCreateFence(m_Handle, &fenceInfo, nullptr, &fence));
+    }
+
+    CreatePipelineCache();
+
+    m_pAllocator = new Allocator(*this);
 }
 
 Device::~Device(void)
 {
-    vkDestroyCommandPool(m_Handle, m_CmdPool, nullptr);
+    SavePipelineCache();
+    for (auto cache : m_ThreadPipelineCaches)
+    {
+        vkDestroyPipelineCache(m_Handle, cache, nullptr);
+    }
+    vkDestroyPipelineCache(m_Handle, m_PipelineCache, nullptr);
+
+    delete m_pAllocator;
+    for (auto fence : m_FreeFences)
+    {
+        vkDestroyFence(m_Handle, fence, nullptr);
+    }
+    /* command buffers are freed with their pool */
+    for (auto& [cmdBuffer, pool] : m_OneTimePools)
+    {
+        vkDestroyCommandPool(m_Handle, pool, nullptr);
+    }
     vkDestroyDevice(m_Handle, nullptr);
 }
 
@@ -137,22 +193,182 @@ const VkPhysicalDevice& Device::GetPhysicalDevice(void) const noexcept
     return m_PhysicalDevice;
 }
 
+VkPhysicalDeviceProperties const& Device::GetProperties(void) const noexcept
+{
+    return m_Properties;
+}
+
+VkPhysicalDeviceMemoryProperties const& Device::GetMemoryProperties(void) const noexcept
+{
+    return m_MemoryProperties;
+}
+
+Allocator& Device::GetAllocator(void) const noexcept
+{
+    return *m_pAllocator;
+}
+
+/**
+* Get the usage of every memory heap
+* Block and allocation counters cover memory allocated through the allocator, Usage and Budget come from
+* VK_EXT_memory_budget when it is enabled, otherwise they are the library's own blocks and 80% of the heap
+*/
+MemoryStats Device::GetMemoryStats(void) const noexcept
+{
+    MemoryStats stats{};
+    stats.HeapCount = m_MemoryProperties.memoryHeapCount;
+    stats.Heaps = m_pAllocator->GetHeapStats();
+
+    if (m_MemoryBudget)
+    {
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProps{};
+        budgetProps.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+        VkPhysicalDeviceMemoryProperties2 memProps2{};
+        memProps2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        memProps2.pNext = &budgetProps;
+        vkGetPhysicalDeviceMemoryProperties2KHR(m_PhysicalDevice, &memProps2);
+
+        for (uint32_t i = 0; i < stats.HeapCount; i++)
+        {
+            stats.Heaps[i].Usage = budgetProps.heapUsage[i];
+            stats.Heaps[i].Budget = budgetProps.heapBudget[i];
+        }
+        stats.BudgetQueried = true;
+    }
+    else
+    {
+        for (uint32_t i = 0; i < stats.HeapCount; i++)
+        {
+            stats.Heaps[i].Usage = stats.Heaps[i].BlockBytes;
+            stats.Heaps[i].Budget = m_MemoryProperties.memoryHeaps[i].size * 8 / 10;
+        }
+    }
+    return stats;
+}
+
 bool Device::ExtensionSupported(const std::string& name) const noexcept
 {
     return m_SupportedExtensions.end() != std::find(m_SupportedExtensions.begin(), m_SupportedExtensions.end(), name);
 }
 
+/**
+* Take an unsignaled fence from the recycled ones, creating one only when none is left
+*/
+VkFence Device::AcquireFence(void) const noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_RecycleMutex);
+        if (!m_FreeFences.empty())
+        {
+            VkFence fence = m_FreeFences.back();
+            m_FreeFences.pop_back();
+            return fence;
+        }
+    }
+    VkFenceCreateInfo fenceInfo = vks::inits::fenceCreateInfo(VK_FLAGS_NONE);
+    VkFence fence;
+    VK_CHK(vkCreateFence(m_Handle, &fenceInfo, nullptr, &fence));
+    return fence;
+}
+
+/**
+* Reset a fence whose submit has completed and keep it for the next blocking submit
+*/
+void Device::ReleaseFence(VkFence fence) const noexcept
+{
+    VK_CHK(vkResetFences(m_Handle, 1, &fence));
+    std::lock_guard<std::mutex> lock(m_RecycleMutex);
+    m_FreeFences.push_back(fence);
+}
+
+/**
+* Submit a command buffer and block until it has finished, the fence comes from the recycled ones
+*/
 void Device::SubmitCommandBuffer(VkCommandBuffer cmdBuffer, VkQueue queue) const noexcept
 {
     VkSubmitInfo submitInfo = vks::inits::submitInfo();
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &cmdBuffer;
-    VkFenceCreateInfo fenceInfo = vks::inits::fenceCreateInfo(VK_FLAGS_NONE);
-    VkFence fence;
-    VK_CHK(vkCreateFence(m_Handle, &fenceInfo, nullptr, &fence));
+    VkFence fence = AcquireFence();
     VK_CHK(vkQueueSubmit(queue, 1, &submitInfo, fence));
     VK_CHK(vkWaitForFences(m_Handle, 1, &fence, VK_TRUE, DEFAULT_FENCE_TIMEOUT));
-    vkDestroyFence(m_Handle, fence, nullptr);
+    ReleaseFence(fence);
+}
+
+/**
+* Create a transient command pool of the graphics family with one primary command buffer and remember it
+* for FlushOneTimeCommandBuffer and the destructor
+*/
+Device::OneTimeCommands Device::CreateOneTimeCommands(void) const noexcept
+{
+    OneTimeCommands commands{};
+    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    cmdPoolInfo.queueFamilyIndex = QueueIndex.Graphics;
+    VK_CHK(vkCreateCommandPool(m_Handle, &cmdPoolInfo, nullptr, &commands.Pool));
+    VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+        vks::inits::commandBufferAllocateInfo(commands.Pool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+    VK_CHK(vkAllocateCommandBuffers(m_Handle, &cmdBufAllocateInfo, &commands.CmdBuffer));
+
+    std::lock_guard<std::mutex> lock(m_RecycleMutex);
+    m_OneTimePools[commands.CmdBuffer] = commands.Pool;
+    return commands;
+}
+
+/**
+* Take a recycled command buffer of the graphics family and begin it for one-time submission
+* Every command buffer has its own pool, so any number of them may be recorded at once on any threads
+*/
+VkCommandBuffer Device::BeginOneTimeCommandBuffer(void) const noexcept
+{
+    std::optional<OneTimeCommands> commands;
+    {
+        std::lock_guard<std::mutex> lock(m_RecycleMutex);
+        if (!m_FreeOneTimeCommands.empty())
+        {
+            commands = m_FreeOneTimeCommands.back();
+            m_FreeOneTimeCommands.pop_back();
+        }
+    }
+    if (!commands)
+    {
+        commands = CreateOneTimeCommands();
+    }
+
+    VkCommandBufferBeginInfo cmdBufInfo = vks::inits::commandBufferBeginInfo();
+    cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHK(vkBeginCommandBuffer(commands->CmdBuffer, &cmdBufInfo));
+    return commands->CmdBuffer;
+}
+
+/**
+* End a command buffer from BeginOneTimeCommandBuffer, submit it, wait for it and recycle it with its pool
+*
+* @param queue a queue of the graphics family
+*/
+void Device::FlushOneTimeCommandBuffer(VkCommandBuffer cmdBuffer, VkQueue queue) const noexcept
+{
+    VK_CHK(vkEndCommandBuffer(cmdBuffer));
+    SubmitCommandBuffer(cmdBuffer, queue);
+
+    VkCommandPool pool = VK_NULL_HANDLE;
+    {
+        std::lock_guard<std::mutex> lock(m_RecycleMutex);
+        auto found = m_OneTimePools.find(cmdBuffer);
+        if (m_OneTimePools.end() != found)
+        {
+            pool = found->second;
+        }
+    }
+    if (VK_NULL_HANDLE == pool)
+    {
+        spdlog::error("Command buffer was not begun by BeginOneTimeCommandBuffer");
+        return;
+    }
+    /* only this thread holds the pool until it is back on the free list */
+    VK_CHK(vkResetCommandPool(m_Handle, pool, 0));
+
+    std::lock_guard<std::mutex> lock(m_RecycleMutex);
+    m_FreeOneTimeCommands.push_back({ pool, cmdBuffer });
 }
 
 std::optional<VkFormat> Device::SupportedDepthStencilFormat(void) const noexcept
@@ -234,4 +450,238 @@ std::optional<uint32_t> Device::GetMemoryType(uint32_t memoryTypeBits, VkMemoryP
 
     return std::nullopt;
 }
+
+/**
+* Get the memory type that best fits a usage
+*
+* @param memoryTypeBits Bit mask with bits set for each memory type supported by the resource to request for (from VkMemoryRequirements)
+* @param usage how the resource is accessed
+*
+* @return optional index of the best memory type
+*/
+std::optional<uint32_t> Device::GetMemoryType(uint32_t memoryTypeBits, MemoryUsage usage) const noexcept
+{
+    std::vector<uint32_t> ranked = RankMemoryTypes(memoryTypeBits, usage);
+    if (ranked.empty())
+    {
+        return std::nullopt;
+    }
+    return ranked.front();
+}
+
+/**
+* Rank every memory type usable for a usage, best fit first
+* A type scores for each preferred property it has and loses for each property the usage should avoid,
+* ties keep the driver's order, which lists faster types first
+*
+* @param memoryTypeBits Bit mask with bits set for each memory type supported by the resource to request for (from VkMemoryRequirements)
+* @param usage how the resource is accessed
+*
+* @return indices of the memory types having every required property, empty if there are none
+*/
+std::vector<uint32_t> Device::RankMemoryTypes(uint32_t memoryTypeBits, MemoryUsage usage) const noexcept
+{
+    VkMemoryPropertyFlags required = 0;
+    VkMemoryPropertyFlags preferred = 0;
+    VkMemoryPropertyFlags secondary = 0;
+    /* lazily allocated and protected memory need special handling, device coherent memory is slow */
+    VkMemoryPropertyFlags avoided = VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT | VK_MEMORY_PROPERTY_PROTECTED_BIT |
+        VK_MEMORY_PROPERTY_DEVICE_COHERENT_BIT_AMD | VK_MEMORY_PROPERTY_DEVICE_UNCACHED_BIT_AMD;
+    switch (usage)
+    {
+    case MemoryUsage::GpuOnly:
+        /* keep host visible device memory (ReBAR) for data the CPU writes */
+        preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        avoided |= VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        break;
+    case MemoryUsage::Upload:
+        /* staging goes to system memory, write-combined rather than cached */
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        secondary = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        avoided |= VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    case MemoryUsage::Readback:
+        /* uncached reads by the CPU are very slow */
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        preferred = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        secondary = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        break;
+    case MemoryUsage::CpuToGpu:
+        /* host visible device memory when there is some, system memory otherwise */
+        required = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT;
+        preferred = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+        secondary = VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        avoided |= VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+        break;
+    }
+
+    std::vector<std::pair<int, uint32_t>> candidates;
+    for (uint32_t i = 0; i < m_MemoryProperties.memoryTypeCount; i++)
+    {
+        VkMemoryPropertyFlags flags = m_MemoryProperties.memoryTypes[i].propertyFlags;
+        if (!(memoryTypeBits & 1 << i) || ((flags & required) != required))
+        {
+            continue;
+        }
+        int score = 4 * std::popcount(flags & preferred) + 2 * std::popcount(flags & secondary) - 3 * std::popcount(flags & avoided);
+        candidates.push_back({ score, i });
+    }
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](auto const& a, auto const& b) { return a.first > b.first; });
+
+    std::vector<uint32_t> ranked;
+    for (auto const& candidate : candidates)
+    {
+        ranked.push_back(candidate.second);
+    }
+    return ranked;
+}
+
+/**
+* Check that pipeline cache data was written by the driver and device in use, drivers are only required to
+* reject data of another device, and some crash on it instead
+*/
+bool Device::ValidatePipelineCacheHeader(std::vector<uint8_t> const& data) const noexcept
+{
+    VkPipelineCacheHeaderVersionOne header;
+    if (data.size() < sizeof(header))
+    {
+        return false;
+    }
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    return (header.headerSize >= sizeof(header)) && (header.headerSize <= data.size()) &&
+        (VK_PIPELINE_CACHE_HEADER_VERSION_ONE == header.headerVersion) &&
+        (header.vendorID == m_Properties.vendorID) && (header.deviceID == m_Properties.deviceID) &&
+        (0 == std::memcmp(header.pipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE));
+}
+
+/**
+* Create the device pipeline cache, seeded from the cache file when its header matches this device
+*/
+void Device::CreatePipelineCache(void) noexcept
+{
+    std::vector<uint8_t> data;
+    if (!m_PipelineCachePath.empty())
+    {
+        std::ifstream ifs(m_PipelineCachePath, std::ios::binary);
+        if (ifs.is_open())
+        {
+            data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+            if (!ValidatePipelineCacheHeader(data))
+            {
+                spdlog::warn("Pipeline cache \"{}\" was written by another driver or device, it is ignored", m_PipelineCachePath);
+                data.clear();
+            }
+        }
+        else
+        {
+            spdlog::info("No pipeline cache at \"{}\", starting with an empty one", m_PipelineCachePath);
+        }
+    }
+
+    VkPipelineCacheCreateInfo cacheCreateInfo = vks::inits::pipelineCacheCreateInfo(data.size(), data.data());
+    if (VK_SUCCESS != vkCreatePipelineCache(m_Handle, &cacheCreateInfo, nullptr, &m_PipelineCache))
+    {
+        spdlog::warn("Pipeline cache \"{}\" was rejected by the driver, starting with an empty one", m_PipelineCachePath);
+        cacheCreateInfo = vks::inits::pipelineCacheCreateInfo();
+        VK_CHK(vkCreatePipelineCache(m_Handle, &cacheCreateInfo, nullptr, &m_PipelineCache));
+    }
+}
+
+/**
+* Pipeline cache to pass to vkCreate*Pipelines, it is internally synchronized and may be used from any thread
+*/
+VkPipelineCache Device::GetPipelineCache(void) const noexcept
+{
+    return m_PipelineCache;
+}
+
+/**
+* Read the contents of a pipeline cache, other threads may keep adding pipelines to it meanwhile
+* so the size is queried again whenever the cache outgrew the buffer
+*/
+std::vector<uint8_t> Device::GetPipelineCacheData(VkPipelineCache cache) const noexcept
+{
+    std::vector<uint8_t> data;
+    VkResult result;
+    do
+    {
+        size_t size = 0;
+        VK_CHK(vkGetPipelineCacheData(m_Handle, cache, &size, nullptr));
+        data.resize(size);
+        result = vkGetPipelineCacheData(m_Handle, cache, &size, data.data());
+        data.resize(size);
+    } while (VK_INCOMPLETE == result);
+    VK_CHK(result);
+    return data;
+}
+
+/**
+* Create a pipeline cache for one worker thread, so threads compiling in parallel do not contend on the
+* device cache's lock, it starts as a copy of the device cache and is owned by the device
+* It is saved along with the device cache by SavePipelineCache
+*/
+VkPipelineCache Device::CreateThreadPipelineCache(void) const noexcept
+{
+    std::vector<uint8_t> data = GetPipelineCacheData(m_PipelineCache);
+
+    VkPipelineCache cache;
+    VkPipelineCacheCreateInfo cacheCreateInfo = vks::inits::pipelineCacheCreateInfo(data.size(), data.data());
+    VK_CHK(vkCreatePipelineCache(m_Handle, &cacheCreateInfo, nullptr, &cache));
+
+    std::lock_guard<std::mutex> lock(m_PipelineCacheMutex);
+    m_ThreadPipelineCaches.push_back(cache);
+    return cache;
+}
+
+/**
+* Write the device cache and the thread caches to the cache file, called by the destructor
+* They are merged into a temporary cache, vkMergePipelineCaches needs its destination externally synchronized
+* and the device and thread caches stay in use by other threads, so it may be called from any thread
+* The file is written next to the old one and renamed over it, so a crash never leaves a truncated cache
+*
+* @return false if the cache could not be written, true on success or when the device has no cache file
+*/
+bool Device::SavePipelineCache(void) const noexcept
+{
+    if (m_PipelineCachePath.empty())
+    {
+        return true;
+    }
+
+    VkPipelineCache merged;
+    VkPipelineCacheCreateInfo cacheCreateInfo = vks::inits::pipelineCacheCreateInfo();
+    VK_CHK(vkCreatePipelineCache(m_Handle, &cacheCreateInfo, nullptr, &merged));
+    {
+        std::lock_guard<std::mutex> lock(m_PipelineCacheMutex);
+        std::vector<VkPipelineCache> caches = m_ThreadPipelineCaches;
+        caches.push_back(m_PipelineCache);
+        VK_CHK(vkMergePipelineCaches(m_Handle, merged, (uint32_t)caches.size(), caches.data()));
+    }
+    std::vector<uint8_t> data = GetPipelineCacheData(merged);
+    vkDestroyPipelineCache(m_Handle, merged, nullptr);
+
+    std::string tmpPath = m_PipelineCachePath + ".tmp";
+    {
+        std::ofstream ofs(tmpPath, std::ios::binary | std::ios::trunc);
+        ofs.write(reinterpret_cast<char const*>(data.data()), (std::streamsize)data.size());
+        ofs.close();
+        if (ofs.fail())
+        {
+            spdlog::error("Could not write pipeline cache \"{}\"", tmpPath);
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpPath, m_PipelineCachePath, ec);
+    if (ec)
+    {
+        spdlog::error("Could not replace pipeline cache \"{}\": {}", m_PipelineCachePath, ec.message());
+        std::filesystem::remove(tmpPath, ec);
+        return false;
+    }
+    return true;
+}
 }
@@ -0,0 +1,106 @@
+#include <algorithm>
+
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/FrameArena.hpp"
+
+namespace vks
+{
+/**
+* @param device logical device the arena buffer is created on
+* @param frameCount number of frames in flight, Swapchain::GetMaxFramesInFlight() or RenderTarget::GetMaxFramesInFlight()
+* @param sliceSize bytes available to a single frame, rounded up to the offset alignment
+* @param usageFlags usage of the shared buffer
+*/
+FrameArena::FrameArena(Device const& device, uint32_t frameCount, VkDeviceSize sliceSize, VkBufferUsageFlags usageFlags) noexcept
+    : m_Device(device), m_FrameCount(frameCount), m_CurrentFrame(0), m_Head(0)
+{
+    assert(frameCount > 0);
+    VkPhysicalDeviceLimits const& limits = device.GetProperties().limits;
+    /* slices start on an atom too, so flushing one frame never touches the range of another */
+    m_MinAlignment = std::max(limits.minUniformBufferOffsetAlignment, limits.nonCoherentAtomSize);
+    m_SliceSize = (sliceSize + m_MinAlignment - 1) / m_MinAlignment * m_MinAlignment;
+
+    m_pBuffer = new Buffer(
+        device,
+        usageFlags,
+        MemoryUsage::CpuToGpu,
+        m_SliceSize * frameCount,
+        nullptr,
+        true
+    );
+}
+
+FrameArena::~FrameArena(void) noexcept
+{
+    delete m_pBuffer;
+}
+
+/**
+* Bump allocate from the slice of the current frame, safe to call from several threads
+*
+* @param size number of bytes
+* @param alignment required alignment, never less than minUniformBufferOffsetAlignment
+* @return the allocation, or nullopt when the slice is exhausted
+*/
+std::optional<FrameArena::Suballocation> FrameArena::Allocate(VkDeviceSize size, VkDeviceSize alignment) noexcept
+{
+    alignment = std::max(alignment, m_MinAlignment);
+
+    VkDeviceSize head = m_Head.load(std::memory_order_relaxed);
+    VkDeviceSize offset;
+    do
+    {
+        offset = (head + alignment - 1) / alignment * alignment;
+        if (offset + size > m_SliceSize)
+        {
+            spdlog::error("FrameArena slice of {} bytes exhausted by a {} byte allocation", m_SliceSize, size);
+            return std::nullopt;
+        }
+    } while (!m_Head.compare_exchange_weak(head, offset + size, std::memory_order_relaxed));
+
+    offset += static_cast<VkDeviceSize>(m_CurrentFrame) * m_SliceSize;
+    return Suballocation{ *m_pBuffer, offset, static_cast<uint8_t*>(m_pBuffer->GetMappedData()) + offset };
+}
+
+/**
+* Make a frame current and drop everything allocated in its slice
+* Call once the fence of that frame has signaled, Swapchain::AcquireNextImage waits on it
+*/
+void FrameArena::BeginFrame(uint32_t frameIndex) noexcept
+{
+    assert(frameIndex < m_FrameCount);
+    m_CurrentFrame = frameIndex;
+    m_Head.store(0, std::memory_order_relaxed);
+}
+
+/**
+* Flush the used part of the current slice, a no-op on HOST_COHERENT memory
+*/
+VkResult FrameArena::Flush(void) noexcept
+{
+    VkDeviceSize used = m_Head.load(std::memory_order_relaxed);
+    if (0 == used)
+    {
+        return VK_SUCCESS;
+    }
+    m_pBuffer->MarkDirty(static_cast<VkDeviceSize>(m_CurrentFrame) * m_SliceSize, used);
+    return m_pBuffer->FlushDirty();
+}
+
+VkBuffer FrameArena::GetBuffer(void) const noexcept
+{
+    return *m_pBuffer;
+}
+
+VkDeviceSize FrameArena::GetSliceSize(void) const noexcept
+{
+    return m_SliceSize;
+}
+
+VkDeviceSize FrameArena::GetUsed(void) const noexcept
+{
+    return m_Head.load(std::memory_order_relaxed);
+}
+}
@@ -0,0 +1,402 @@
+#include <algorithm>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/FrameCapture.hpp"
+
+namespace vks
+{
+/* bytes per texel of the uncompressed color formats, 0 for formats a color copy cannot read back tightly packed */
+static VkDeviceSize GetFormatSize(VkFormat format) noexcept
+{
+    switch (format)
+    {
+    case VK_FORMAT_R4G4_UNORM_PACK8:
+    case VK_FORMAT_R8_UNORM:
+    case VK_FORMAT_R8_SNORM:
+    case VK_FORMAT_R8_USCALED:
+    case VK_FORMAT_R8_SSCALED:
+    case VK_FORMAT_R8_UINT:
+    case VK_FORMAT_R8_SINT:
+    case VK_FORMAT_R8_SRGB:
+        return 1;
+    case VK_FORMAT_R4G4B4A4_UNORM_PACK16:
+    case VK_FORMAT_B4G4R4A4_UNORM_PACK16:
+    case VK_FORMAT_R5G6B5_UNORM_PACK16:
+    case VK_FORMAT_B5G6R5_UNORM_PACK16:
+    case VK_FORMAT_R5G5B5A1_UNORM_PACK16:
+    case VK_FORMAT_B5G5R5A1_UNORM_PACK16:
+    case VK_FORMAT_A1R5G5B5_UNORM_PACK16:
+    case VK_FORMAT_R8G8_UNORM:
+    case VK_FORMAT_R8G8_SNORM:
+    case VK_FORMAT_R8G8_USCALED:
+    case VK_FORMAT_R8G8_SSCALED:
+    case VK_FORMAT_R8G8_UINT:
+    case VK_FORMAT_R8G8_SINT:
+    case VK_FORMAT_R8G8_SRGB:
+    case VK_FORMAT_R16_UNORM:
+    case VK_FORMAT_R16_SNORM:
+    case VK_FORMAT_R16_USCALED:
+    case VK_FORMAT_R16_SSCALED:
+    case VK_FORMAT_R16_UINT:
+    case VK_FORMAT_R16_SINT:
+    case VK_FORMAT_R16_SFLOAT:
+        return 2;
+    case VK_FORMAT_R8G8B8_UNORM:
+    case VK_FORMAT_R8G8B8_SNORM:
+    case VK_FORMAT_R8G8B8_USCALED:
+    case VK_FORMAT_R8G8B8_SSCALED:
+    case VK_FORMAT_R8G8B8_UINT:
+    case VK_FORMAT_R8G8B8_SINT:
+    case VK_FORMAT_R8G8B8_SRGB:
+    case VK_FORMAT_B8G8R8_UNORM:
+    case VK_FORMAT_B8G8R8_SNORM:
+    case VK_FORMAT_B8G8R8_USCALED:
+    case VK_FORMAT_B8G8R8_SSCALED:
+    case VK_FORMAT_B8G8R8_UINT:
+    case VK_FORMAT_B8G8R8_SINT:
+    case VK_FORMAT_B8G8R8_SRGB:
+        return 3;
+    case VK_FORMAT_R8G8B8A8_UNORM:
+    case VK_FORMAT_R8G8B8A8_SNORM:
+    case VK_FORMAT_R8G8B8A8_USCALED:
+    case VK_FORMAT_R8G8B8A8_SSCALED:
+    case VK_FORMAT_R8G8B8A8_UINT:
+    case VK_FORMAT_R8G8B8A8_SINT:
+    case VK_FORMAT_R8G8B8A8_SRGB:
+    case VK_FORMAT_B8G8R8A8_UNORM:
+    case VK_FORMAT_B8G8R8A8_SNORM:
+    case VK_FORMAT_B8G8R8A8_USCALED:
+    case VK_FORMAT_B8G8R8A8_SSCALED:
+    case VK_FORMAT_B8G8R8A8_UINT:
+    case VK_FORMAT_B8G8R8A8_SINT:
+    case VK_FORMAT_B8G8R8A8_SRGB:
+    case VK_FORMAT_A8B8G8R8_UNORM_PACK32:
+    case VK_FORMAT_A8B8G8R8_SNORM_PACK32:
+    case VK_FORMAT_A8B8G8R8_USCALED_PACK32:
+    case VK_FORMAT_A8B8G8R8_SSCALED_PACK32:
+    case VK_FORMAT_A8B8G8R8_UINT_PACK32:
+    case VK_FORMAT_A8B8G8R8_SINT_PACK32:
+    case VK_FORMAT_A8B8G8R8_SRGB_PACK32:
+    case VK_FORMAT_A2R10G10B10_UNORM_PACK32:
+    case VK_FORMAT_A2R10G10B10_SNORM_PACK32:
+    case VK_FORMAT_A2R10G10B10_USCALED_PACK32:
+    case VK_FORMAT_A2R10G10B10_SSCALED_PACK32:
+    case VK_FORMAT_A2R10G10B10_UINT_PACK32:
+    case VK_FORMAT_A2R10G10B10_SINT_PACK32:
+    case VK_FORMAT_A2B10G10R10_UNORM_PACK32:
+    case VK_FORMAT_A2B10G10R10_SNORM_PACK32:
+    case VK_FORMAT_A2B10G10R10_USCALED_PACK32:
+    case VK_FORMAT_A2B10G10R10_SSCALED_PACK32:
+    case VK_FORMAT_A2B10G10R10_UINT_PACK32:
+    case VK_FORMAT_A2B10G10R10_SINT_PACK32:
+    case VK_FORMAT_R16G16_UNORM:
+    case VK_FORMAT_R16G16_SNORM:
+    case VK_FORMAT_R16G16_USCALED:
+    case VK_FORMAT_R16G16_SSCALED:
+    case VK_FORMAT_R16G16_UINT:
+    case VK_FORMAT_R16G16_SINT:
+    case VK_FORMAT_R16G16_SFLOAT:
+    case VK_FORMAT_R32_UINT:
+    case VK_FORMAT_R32_SINT:
+    case VK_FORMAT_R32_SFLOAT:
+    case VK_FORMAT_B10G11R11_UFLOAT_PACK32:
+    case VK_FORMAT_E5B9G9R9_UFLOAT_PACK32:
+        return 4;
+    case VK_FORMAT_R16G16B16_UNORM:
+    case VK_FORMAT_R16G16B16_SNORM:
+    case VK_FORMAT_R16G16B16_USCALED:
+    case VK_FORMAT_R16G16B16_SSCALED:
+    case VK_FORMAT_R16G16B16_UINT:
+    case VK_FORMAT_R16G16B16_SINT:
+    case VK_FORMAT_R16G16B16_SFLOAT:
+        return 6;
+    case VK_FORMAT_R16G16B16A16_UNORM:
+    case VK_FORMAT_R16G16B16A16_SNORM:
+    case VK_FORMAT_R16G16B16A16_USCALED:
+    case VK_FORMAT_R16G16B16A16_SSCALED:
+    case VK_FORMAT_R16G16B16A16_UINT:
+    case VK_FORMAT_R16G16B16A16_SINT:
+    case VK_FORMAT_R16G16B16A16_SFLOAT:
+    case VK_FORMAT_R32G32_UINT:
+    case VK_FORMAT_R32G32_SINT:
+    case VK_FORMAT_R32G32_SFLOAT:
+    case VK_FORMAT_R64_UINT:
+    case VK_FORMAT_R64_SINT:
+    case VK_FORMAT_R64_SFLOAT:
+        return 8;
+    case VK_FORMAT_R32G32B32_UINT:
+    case VK_FORMAT_R32G32B32_SINT:
+    case VK_FORMAT_R32G32B32_SFLOAT:
+        return 12;
+    case VK_FORMAT_R32G32B32A32_UINT:
+    case VK_FORMAT_R32G32B32A32_SINT:
+    case VK_FORMAT_R32G32B32A32_SFLOAT:
+    case VK_FORMAT_R64G64_UINT:
+    case VK_FORMAT_R64G64_SINT:
+    case VK_FORMAT_R64G64_SFLOAT:
+        return 16;
+    case VK_FORMAT_R64G64B64_UINT:
+    case VK_FORMAT_R64G64B64_SINT:
+    case VK_FORMAT_R64G64B64_SFLOAT:
+        return 24;
+    case VK_FORMAT_R64G64B64A64_UINT:
+    case VK_FORMAT_R64G64B64A64_SINT:
+    case VK_FORMAT_R64G64B64A64_SFLOAT:
+        return 32;
+    default:
+        return 0;
+    }
+}
+
+/**
+* @param extent size of the captured images
+* @param format format of the captured images, the pixels are copied as is
+* @param capture called with every captured frame from a worker thread
+* @param slotCount readback buffers in the ring
+* @param threadCount worker threads waiting on the copies and running the callback
+* @param overflow whether RecordCopy drops the frame or waits for a slot when all of them are in use
+*/
+FrameCapture::FrameCapture(
+    Device const& device,
+    VkExtent2D extent,
+    VkFormat format,
+    CaptureFunc capture,
+    uint32_t slotCount,
+    uint32_t threadCount,
+    Overflow overflow
+) noexcept
+    : m_Device(device), m_Capture(std::move(capture)), m_Extent(extent), m_Format(format), m_FrameSize(0),
+    m_Overflow(overflow), m_SlotCount(std::max(slotCount, 1u)), m_FrameIndex(0), m_DroppedFrames(0), m_Busy(0), m_Stop(false)
+{
+    CreateSlots();
+    for (uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+    {
+        m_Workers.emplace_back(&FrameCapture::WorkerLoop, this);
+    }
+}
+
+/**
+* Finish every submitted capture, then stop the workers
+*/
+FrameCapture::~FrameCapture(void) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkCv.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+    DestroySlots();
+}
+
+void FrameCapture::CreateSlots(void) noexcept
+{
+    if (0 == GetFormatSize(m_Format))
+    {
+        spdlog::error("Frame capture does not support format {}, no frame will be captured", (int)m_Format);
+        return;
+    }
+    m_FrameSize = (VkDeviceSize)m_Extent.width * m_Extent.height * GetFormatSize(m_Format);
+    if (0 == m_FrameSize)
+    {
+        /* e.g. a minimized window, capture resumes with the next Resize */
+        return;
+    }
+
+    VkFenceCreateInfo fenceCreateInfo = vks::inits::fenceCreateInfo();
+    m_Slots.resize(m_SlotCount);
+    for (auto& slot : m_Slots)
+    {
+        /* persistently mapped, Readback prefers HOST_CACHED memory so the workers read it at full speed */
+        slot.pBuffer = new Buffer(m_Device, VK_BUFFER_USAGE_TRANSFER_DST_BIT, MemoryUsage::Readback, m_FrameSize, nullptr, true);
+        VK_CHK(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &slot.Fence));
+        slot.Frame = 0;
+        slot.State = SlotState::Free;
+    }
+}
+
+void FrameCapture::DestroySlots(void) noexcept
+{
+    for (auto& slot : m_Slots)
+    {
+        delete slot.pBuffer;
+        vkDestroyFence(m_Device, slot.Fence, nullptr);
+    }
+    m_Slots.clear();
+}
+
+void FrameCapture::WorkerLoop(void) noexcept
+{
+    while (true)
+    {
+        uint32_t index;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCv.wait(lock, [this] { return m_Stop || !m_Submitted.empty(); });
+            /* stopping still drains the submitted slots */
+            if (m_Submitted.empty())
+            {
+                return;
+            }
+            index = m_Submitted.front();
+            m_Submitted.pop_front();
+        }
+
+        Slot& slot = m_Slots[index];
+        VK_CHK(vkWaitForFences(m_Device, 1, &slot.Fence, VK_TRUE, UINT64_MAX));
+        VK_CHK(vkResetFences(m_Device, 1, &slot.Fence));
+        VK_CHK(slot.pBuffer->Invalidate());
+
+        Frame frame{ slot.Frame, m_Extent, m_Format, slot.pBuffer->GetMappedData(), m_FrameSize };
+        m_Capture(frame);
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            slot.State = SlotState::Free;
+            m_Busy--;
+        }
+        m_FreeCv.notify_all();
+    }
+}
+
+/**
+* Record the copy of a rendered image into a free readback buffer, after the image's last write
+*
+* @param cmdBuffer command buffer of the frame, submitted before the image is presented
+* @param layout layout the image is in and is left in, e.g. VK_IMAGE_LAYOUT_PRESENT_SRC_KHR
+*
+* @return index of the captured frame, std::nullopt if the frame is dropped, with Overflow::Drop when every
+* slot is busy, or not captured, while the extent has no area or when the format is not supported
+*/
+std::optional<uint64_t> FrameCapture::RecordCopy(VkCommandBuffer cmdBuffer, VkImage image, VkImageLayout layout) noexcept
+{
+    assert(!m_Recorded && "Submit the previous capture first");
+
+    if (m_Slots.empty())
+    {
+        return std::nullopt;
+    }
+
+    uint64_t frameIndex = m_FrameIndex++;
+    {
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        if (Overflow::Wait == m_Overflow)
+        {
+            /* every busy slot is submitted, the workers free them */
+            m_FreeCv.wait(lock, [this] { return m_Busy < m_Slots.size(); });
+        }
+        for (uint32_t i = 0; i < m_Slots.size(); i++)
+        {
+            if (SlotState::Free == m_Slots[i].State)
+            {
+                m_Slots[i].State = SlotState::Recorded;
+                m_Busy++;
+                m_Recorded = i;
+                break;
+            }
+        }
+    }
+    if (!m_Recorded)
+    {
+        m_DroppedFrames++;
+        spdlog::debug("Frame capture dropped frame {}, all {} readback slots are busy", frameIndex, m_Slots.size());
+        return std::nullopt;
+    }
+
+    Slot& slot = m_Slots[*m_Recorded];
+    slot.Frame = frameIndex;
+
+    VkImageSubresourceRange range = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    VkImageMemoryBarrier toTransfer = vks::inits::imageMemoryBarrier();
+    toTransfer.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    toTransfer.oldLayout = layout;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toTransfer.image = image;
+    toTransfer.subresourceRange = range;
+    vkCmdPipelineBarrier(cmdBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &toTransfer);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { m_Extent.width, m_Extent.height, 1 };
+    vkCmdCopyImageToBuffer(cmdBuffer, image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, *slot.pBuffer, 1, &region);
+
+    /* hand the image back in its layout and make the copy visible to the host */
+    VkImageMemoryBarrier toLayout = toTransfer;
+    toLayout.srcAccessMask = 0;
+    toLayout.dstAccessMask = 0;
+    toLayout.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    toLayout.newLayout = layout;
+    VkBufferMemoryBarrier toHost = vks::inits::bufferMemoryBarrier();
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.buffer = *slot.pBuffer;
+    toHost.offset = 0;
+    toHost.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmdBuffer,
+        VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+        0, 0, nullptr, 1, &toHost, 1, &toLayout);
+
+    return frameIndex;
+}
+
+/**
+* Hand the recorded copy to the workers, call right after the frame's command buffer was submitted to queue
+* The empty submit signals the slot's fence once everything submitted before it, the copy included, finished
+*/
+void FrameCapture::Submit(VkQueue queue) noexcept
+{
+    if (!m_Recorded)
+    {
+        return;
+    }
+
+    uint32_t index = *m_Recorded;
+    m_Recorded.reset();
+    VK_CHK(vkQueueSubmit(queue, 0, nullptr, m_Slots[index].Fence));
+
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Slots[index].State = SlotState::Submitted;
+        m_Submitted.push_back(index);
+    }
+    m_WorkCv.notify_one();
+}
+
+/**
+* Block until every submitted capture has been handed to the callback, e.g. at the end of a recording
+*/
+void FrameCapture::WaitIdle(void) noexcept
+{
+    assert(!m_Recorded && "Submit the recorded capture first");
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_FreeCv.wait(lock, [this] { return 0 == m_Busy; });
+}
+
+/**
+* Follow a swapchain or render target resize, waits for the pending captures, a zero-area extent pauses capture
+*/
+void FrameCapture::Resize(VkExtent2D extent) noexcept
+{
+    WaitIdle();
+    DestroySlots();
+    m_Extent = extent;
+    CreateSlots();
+}
+
+/**
+* Frames not captured because every readback slot was busy, raise the slot count if this grows
+*/
+uint64_t FrameCapture::GetDroppedFrames(void) const noexcept
+{
+    return m_DroppedFrames;
+}
+}
@@ -0,0 +1,155 @@
+#include <algorithm>
+
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+#include "vks/Swapchain.hpp"
+
+#include "vks/FramePacer.hpp"
+
+namespace vks
+{
+/* device level, loaded by the first FramePacer since the application targets Vulkan 1.0 */
+static PFN_vkWaitForPresentKHR vkWaitForPresentKHR = nullptr;
+
+/**
+* @param device logical device, VK_KHR_present_id and VK_KHR_present_wait have to be enabled for pacing
+* @param swapchain swapchain every present of the frame loop goes to
+* @param targetLatency presents allowed to stay queued when WaitForLatency returns
+*/
+FramePacer::FramePacer(Device const& device, Swapchain const& swapchain, uint32_t targetLatency) noexcept
+    : m_Device(device), m_Swapchain(swapchain), m_Enabled(false), m_TargetLatency(targetLatency),
+    m_WaitTimeout(DEFAULT_WAIT_TIMEOUT), m_PresentId(0), m_FirstPresentId(0), m_CompletedId(0),
+    m_LastSwapchain(VK_NULL_HANDLE), m_LastCompletionId(0), m_Intervals{}, m_IntervalCount(0)
+{
+    vkWaitForPresentKHR = reinterpret_cast<PFN_vkWaitForPresentKHR>(vkGetDeviceProcAddr(device, "vkWaitForPresentKHR"));
+    m_Enabled = (nullptr != vkWaitForPresentKHR);
+    if (!m_Enabled)
+    {
+        spdlog::info("VK_KHR_present_wait is not enabled, frame pacing is disabled");
+    }
+}
+
+/**
+* Present the current frame of the swapchain, tagged with the next present id
+*/
+VkResult FramePacer::QueuePresent(VkQueue queue) noexcept
+{
+    uint64_t presentId = ++m_PresentId;
+
+    /* ids presented to a retired swapchain will never complete on the new one */
+    VkSwapchainKHR swapchain = m_Swapchain;
+    if (swapchain != m_LastSwapchain)
+    {
+        m_LastSwapchain = swapchain;
+        m_FirstPresentId = presentId;
+        m_CompletedId = presentId - 1;
+        m_LastCompletionId = 0;
+    }
+
+    return m_Swapchain.QueuePresent(queue, m_Enabled ? presentId : 0);
+}
+
+/**
+* Block until no more than the target latency of presents are queued, call right before sampling input
+*
+* @return VK_SUCCESS when there was nothing to wait for or the present completed, otherwise the result of
+* vkWaitForPresentKHR, e.g. VK_TIMEOUT or VK_ERROR_OUT_OF_DATE_KHR, which the frame loop may ignore
+*/
+VkResult FramePacer::WaitForLatency(void) noexcept
+{
+    if (!m_Enabled || (m_PresentId <= m_TargetLatency) || ((VkSwapchainKHR)m_Swapchain != m_LastSwapchain))
+    {
+        return VK_SUCCESS;
+    }
+
+    uint64_t target = m_PresentId - m_TargetLatency;
+    if ((target < m_FirstPresentId) || (target <= m_CompletedId))
+    {
+        return VK_SUCCESS;
+    }
+
+    VkResult result = vkWaitForPresentKHR(m_Device, m_LastSwapchain, target, m_WaitTimeout);
+    if (VK_SUCCESS != result)
+    {
+        return result;
+    }
+
+    Clock::time_point now = Clock::now();
+    if (0 != m_LastCompletionId)
+    {
+        /* spread the time evenly when presents were skipped between two waits */
+        Clock::duration interval = (now - m_LastCompletion) / (int64_t)(target - m_LastCompletionId);
+        m_Intervals[m_IntervalCount % INTERVAL_HISTORY] = interval;
+        m_IntervalCount++;
+    }
+    m_LastCompletion = now;
+    m_LastCompletionId = target;
+    m_CompletedId = target;
+    return VK_SUCCESS;
+}
+
+/**
+* @param frames presents allowed to stay queued, 0 waits for the last present and gives the lowest latency,
+* 1 keeps one frame queued so the GPU never idles, higher values trade latency for throughput
+*/
+void FramePacer::SetTargetLatency(uint32_t frames) noexcept
+{
+    m_TargetLatency = frames;
+}
+
+void FramePacer::SetWaitTimeout(uint64_t timeout) noexcept
+{
+    m_WaitTimeout = timeout;
+}
+
+bool FramePacer::IsEnabled(void) const noexcept
+{
+    return m_Enabled;
+}
+
+uint32_t FramePacer::GetTargetLatency(void) const noexcept
+{
+    return m_TargetLatency;
+}
+
+uint64_t FramePacer::GetPresentId(void) const noexcept
+{
+    return m_PresentId;
+}
+
+uint64_t FramePacer::GetCompletedId(void) const noexcept
+{
+    return m_CompletedId;
+}
+
+/**
+* Time between the last two waited presents, zero until two have completed
+*/
+FramePacer::Clock::duration FramePacer::GetLastInterval(void) const noexcept
+{
+    if (0 == m_IntervalCount)
+    {
+        return Clock::duration::zero();
+    }
+    return m_Intervals[(m_IntervalCount - 1) % INTERVAL_HISTORY];
+}
+
+/**
+* Average present-to-present interval over the last INTERVAL_HISTORY waits
+*/
+FramePacer::Clock::duration FramePacer::GetAverageInterval(void) const noexcept
+{
+    size_t count = std::min(m_IntervalCount, INTERVAL_HISTORY);
+    if (0 == count)
+    {
+        return Clock::duration::zero();
+    }
+
+    Clock::duration sum = Clock::duration::zero();
+    for (size_t i = 0; i < count; i++)
+    {
+        sum += m_Intervals[i];
+    }
+    return sum / (int64_t)count;
+}
+}
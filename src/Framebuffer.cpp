@@ -1,4 +1,5 @@
 #include "vks/Framebuffer.hpp"
+#include "vks/Inits.hpp"
 #include "vks/Utils.hpp"
 
 namespace vks
@@ -9,12 +10,9 @@ void FramebufferAttachment::Init(void)
     VkMemoryRequirements memReqs{};
     vkGetImageMemoryRequirements(m_Device, m_Image, &memReqs);
 
-    VkMemoryAllocateInfo memAllloc{};
-    memAllloc.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-    memAllloc.allocationSize = memReqs.size;
-    memAllloc.memoryTypeIndex = m_Device.GetMemoryType(memReqs.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT).value();
-    VK_CHK(vkAllocateMemory(m_Device, &memAllloc, nullptr, &m_Memory));
-    VK_CHK(vkBindImageMemory(m_Device, m_Image, m_Memory, 0));
+    bool linear = (VK_IMAGE_TILING_LINEAR == m_ImageCreateInfo.tiling);
+    VK_CHK(m_Device.GetAllocator().Allocate(memReqs, m_Usage, linear, m_Allocation));
+    VK_CHK(vkBindImageMemory(m_Device, m_Image, m_Allocation.Memory, m_Allocation.Offset));
 
     m_ImageViewCreateInfo.image = m_Image;
     VK_CHK(vkCreateImageView(m_Device, &m_ImageViewCreateInfo, nullptr, &m_ImageView));
@@ -23,8 +21,8 @@ void FramebufferAttachment::Init(void)
 void FramebufferAttachment::Destroy(void)
 {
     vkDestroyImageView(m_Device, m_ImageView, nullptr);
-    vkFreeMemory(m_Device, m_Memory, nullptr);
     vkDestroyImage(m_Device, m_Image, nullptr);
+    m_Device.GetAllocator().Free(m_Allocation);
 }
 
 /**
@@ -33,13 +31,15 @@ void FramebufferAttachment::Destroy(void)
 * @param device a valid reference to vks::Device
 * @param imageCI completed VkImageCreateInfo struct
 * @param imageViewCI a VkImageViewCreateInfo struct, its `image` field will be filled by the constructor
+* @param usage how the image memory is accessed, linear tiling images may be read back
 */
 FramebufferAttachment::FramebufferAttachment(
     Device const& device,
     VkImageCreateInfo const& imageCI,
-    VkImageViewCreateInfo& imageViewCI
+    VkImageViewCreateInfo& imageViewCI,
+    MemoryUsage usage
 ) noexcept
-    : m_Device(device), m_ImageCreateInfo(imageCI), m_ImageViewCreateInfo(imageViewCI)
+    : m_Device(device), m_ImageCreateInfo(imageCI), m_ImageViewCreateInfo(imageViewCI), m_Usage(usage)
 {
     Init();
 }
@@ -56,8 +56,48 @@ void FramebufferAttachment::Recreate(VkExtent3D extent) noexcept
     Init();
 }
 
+VkImage const& FramebufferAttachment::GetImage(void) const noexcept
+{
+    return m_Image;
+}
+
 VkImageView const& FramebufferAttachment::GetView(void) const noexcept
 {
     return m_ImageView;
 }
-}
\ No newline at end of file
+
+VkFormat FramebufferAttachment::GetFormat(void) const noexcept
+{
+    return m_ImageCreateInfo.format;
+}
+
+/**
+* Describe the attachment for vkCmdBeginRenderingKHR, the view is used directly without a framebuffer
+*
+* @param layout layout the image is in while rendering, transitions are up to the caller
+*/
+VkRenderingAttachmentInfoKHR FramebufferAttachment::GetRenderingAttachmentInfo(
+    VkImageLayout layout,
+    VkAttachmentLoadOp loadOp,
+    VkAttachmentStoreOp storeOp,
+    VkClearValue clearValue
+) const noexcept
+{
+    return vks::inits::renderingAttachmentInfo(m_ImageView, layout, loadOp, storeOp, clearValue);
+}
+
+VkImageCreateInfo const& FramebufferAttachment::GetImageCreateInfo(void) const noexcept
+{
+    return m_ImageCreateInfo;
+}
+
+VkImageViewCreateInfo const& FramebufferAttachment::GetImageViewCreateInfo(void) const noexcept
+{
+    return m_ImageViewCreateInfo;
+}
+
+MemoryUsage FramebufferAttachment::GetUsage(void) const noexcept
+{
+    return m_Usage;
+}
+}
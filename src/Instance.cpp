@@ -3,25 +3,29 @@
 #include <vulkan/vulkan.h>
 
 #include "vks/Debug.hpp"
+#include "vks/Device.hpp"
 #include "vks/Inits.hpp"
 #include "vks/Utils.hpp"
 #include "vks/Instance.hpp"
 
 namespace vks
 {
+static PFN_vkCreateHeadlessSurfaceEXT vkCreateHeadlessSurfaceEXT = nullptr;
+
+/**
+* @param headless do not require a window system, VK_EXT_headless_surface is enabled when present so a
+* Swapchain can still run on CreateHeadlessSurface, otherwise render to a vks::RenderTarget
+*/
 Instance::Instance(
     VkApplicationInfo appInfo,
     bool validation,
-    std::vector<const char*> enabledExtensions
+    std::vector<const char*> enabledExtensions,
+    bool headless
 ) noexcept
+    : m_HeadlessSurface(false)
 {
     std::vector<const char*> exts(enabledExtensions);
 
-    exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
-#if WIN32
-    exts.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
-#endif
-
     // Get extensions supported by the instance and store for later use
     uint32_t extCnt = 0;
     vkEnumerateInstanceExtensionProperties(nullptr, &extCnt, nullptr);
@@ -35,6 +39,18 @@ Instance::Instance(
         }
     }
 
+    if (!headless) {
+        exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+#if WIN32
+        exts.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+#endif
+    }
+    else if (ExtensionSupported(VK_KHR_SURFACE_EXTENSION_NAME) && ExtensionSupported(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME)) {
+        exts.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
+        exts.push_back(VK_EXT_HEADLESS_SURFACE_EXTENSION_NAME);
+        m_HeadlessSurface = true;
+    }
+
     // Enabled requested instance extensions
     for (const char* ext : exts) {
         std::string str(ext);
@@ -55,6 +71,11 @@ Instance::Instance(
         exts.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     }
 
+    /* lets Device query VK_EXT_memory_budget on a Vulkan 1.0 instance */
+    if (ExtensionSupported(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME)) {
+        exts.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    }
+
     if (!exts.empty()) {
         instCreateInfo.enabledExtensionCount = static_cast<uint32_t>(exts.size());
         instCreateInfo.ppEnabledExtensionNames = exts.data();
@@ -84,6 +105,12 @@ Instance::Instance(
         }
     }
     VK_CHK(vkCreateInstance(&instCreateInfo, nullptr, &m_Handle));
+
+    Device::LoadInstanceFunctions(m_Handle);
+    if (m_HeadlessSurface) {
+        vkCreateHeadlessSurfaceEXT = reinterpret_cast<PFN_vkCreateHeadlessSurfaceEXT>(
+            vkGetInstanceProcAddr(m_Handle, "vkCreateHeadlessSurfaceEXT"));
+    }
 }
 
 Instance::~Instance(void)
@@ -98,4 +125,23 @@ bool Instance::ExtensionSupported(const std::string& name)
 {
     return m_SupportedExtensions.end() != std::find(m_SupportedExtensions.begin(), m_SupportedExtensions.end(), name);
 }
+
+/**
+* Create a surface without a window, presenting to it only paces the frame loop
+*
+* @return the surface, owned by the Swapchain created on it, or std::nullopt when the instance is not
+* headless or the extension is missing
+*/
+std::optional<VkSurfaceKHR> Instance::CreateHeadlessSurface(void) const noexcept
+{
+    if (!m_HeadlessSurface || !vkCreateHeadlessSurfaceEXT) {
+        return std::nullopt;
+    }
+
+    VkHeadlessSurfaceCreateInfoEXT surfaceCI{};
+    surfaceCI.sType = VK_STRUCTURE_TYPE_HEADLESS_SURFACE_CREATE_INFO_EXT;
+    VkSurfaceKHR surface;
+    VK_CHK(vkCreateHeadlessSurfaceEXT(m_Handle, &surfaceCI, nullptr, &surface));
+    return surface;
+}
 }
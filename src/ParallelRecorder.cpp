@@ -0,0 +1,189 @@
+#include <algorithm>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/ParallelRecorder.hpp"
+
+namespace vks
+{
+/**
+* @param device logical device
+* @param queueFamilyIndex family of the queue the primary command buffer is submitted to
+* @param frameCount number of frames in flight
+* @param threadCount number of worker threads, each gets its own command pool per frame
+*/
+ParallelRecorder::ParallelRecorder(Device const& device, uint32_t queueFamilyIndex, uint32_t frameCount, uint32_t threadCount) noexcept
+    : m_Device(device), m_FrameCount(frameCount), m_ThreadCount(std::max(threadCount, 1u)), m_CurrentFrame(0),
+    m_Generation(0), m_WorkersDone(0), m_Stop(false), m_Inheritance(vks::inits::commandBufferInheritanceInfo()),
+    m_SliceCount(0), m_NextSlice(0)
+{
+    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+    cmdPoolInfo.queueFamilyIndex = queueFamilyIndex;
+    m_Pools.resize(m_FrameCount * m_ThreadCount);
+    for (auto& pool : m_Pools)
+    {
+        VK_CHK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &pool.Pool));
+        pool.Used = 0;
+    }
+
+    for (uint32_t i = 0; i < m_ThreadCount; i++)
+    {
+        m_Workers.emplace_back(&ParallelRecorder::WorkerLoop, this, i);
+    }
+}
+
+ParallelRecorder::~ParallelRecorder(void) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+    }
+    m_WorkCv.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+
+    /* command buffers are freed with their pool */
+    for (auto& pool : m_Pools)
+    {
+        vkDestroyCommandPool(m_Device, pool.Pool, nullptr);
+    }
+}
+
+/**
+* Take the next secondary command buffer of a thread's pool for the current frame
+*/
+VkCommandBuffer ParallelRecorder::GetCommandBuffer(uint32_t threadIndex) noexcept
+{
+    ThreadPool& pool = m_Pools[m_CurrentFrame * m_ThreadCount + threadIndex];
+    if (pool.Used == pool.CmdBuffers.size())
+    {
+        VkCommandBuffer cmdBuffer;
+        VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+            vks::inits::commandBufferAllocateInfo(pool.Pool, VK_COMMAND_BUFFER_LEVEL_SECONDARY, 1);
+        VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, &cmdBuffer));
+        pool.CmdBuffers.push_back(cmdBuffer);
+    }
+    return pool.CmdBuffers[pool.Used++];
+}
+
+void ParallelRecorder::WorkerLoop(uint32_t threadIndex) noexcept
+{
+    uint64_t generation = 0;
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCv.wait(lock, [&] { return m_Stop || (m_Generation != generation); });
+            if (m_Stop)
+            {
+                return;
+            }
+            generation = m_Generation;
+        }
+
+        VkCommandBufferBeginInfo cmdBufInfo = vks::inits::commandBufferBeginInfo();
+        cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        cmdBufInfo.pInheritanceInfo = &m_Inheritance;
+
+        /* slices are taken one at a time so uneven slices still balance across threads */
+        uint32_t slice;
+        while ((slice = m_NextSlice.fetch_add(1, std::memory_order_relaxed)) < m_SliceCount)
+        {
+            VkCommandBuffer cmdBuffer = GetCommandBuffer(threadIndex);
+            VK_CHK(vkBeginCommandBuffer(cmdBuffer, &cmdBufInfo));
+            m_Record(cmdBuffer, slice);
+            VK_CHK(vkEndCommandBuffer(cmdBuffer));
+            m_Recorded[slice] = cmdBuffer;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (++m_WorkersDone == m_ThreadCount)
+            {
+                m_DoneCv.notify_one();
+            }
+        }
+    }
+}
+
+/**
+* Make a frame current and reset every command pool of it
+* Call once the fence of that frame has signaled, Swapchain::AcquireNextImage waits on it
+*/
+void ParallelRecorder::BeginFrame(uint32_t frameIndex) noexcept
+{
+    assert(frameIndex < m_FrameCount);
+    m_CurrentFrame = frameIndex;
+    for (uint32_t i = 0; i < m_ThreadCount; i++)
+    {
+        ThreadPool& pool = m_Pools[m_CurrentFrame * m_ThreadCount + i];
+        VK_CHK(vkResetCommandPool(m_Device, pool.Pool, 0));
+        pool.Used = 0;
+    }
+}
+
+/**
+* Record slices of a render pass on the worker threads and wait for all of them
+*
+* @param renderPass render pass the secondary command buffers continue
+* @param subpass subpass the secondary command buffers are executed in
+* @param framebuffer framebuffer of the render pass instance, may be VK_NULL_HANDLE
+* @param sliceCount number of secondary command buffers to record
+* @param record called once per slice from a worker thread, concurrently with other slices
+*
+* @return one secondary command buffer per slice, in slice order, valid until the next Record
+*/
+std::vector<VkCommandBuffer> const& ParallelRecorder::Record(
+    VkRenderPass renderPass,
+    uint32_t subpass,
+    VkFramebuffer framebuffer,
+    uint32_t sliceCount,
+    RecordFunc record
+) noexcept
+{
+    m_Recorded.assign(sliceCount, VK_NULL_HANDLE);
+    if (0 == sliceCount)
+    {
+        return m_Recorded;
+    }
+
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_Record = std::move(record);
+    m_Inheritance.renderPass = renderPass;
+    m_Inheritance.subpass = subpass;
+    m_Inheritance.framebuffer = framebuffer;
+    m_SliceCount = sliceCount;
+    m_NextSlice.store(0, std::memory_order_relaxed);
+    m_WorkersDone = 0;
+    m_Generation++;
+    m_WorkCv.notify_all();
+
+    m_DoneCv.wait(lock, [this] { return m_WorkersDone == m_ThreadCount; });
+    m_Record = nullptr;
+    return m_Recorded;
+}
+
+/**
+* Begin a render pass with secondary command buffer contents, execute the last recorded slices and end it
+*
+* @param primary primary command buffer in the recording state
+*/
+void ParallelRecorder::ExecuteInRenderPass(VkCommandBuffer primary, VkRenderPassBeginInfo const& renderPassBeginInfo) const noexcept
+{
+    vkCmdBeginRenderPass(primary, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+    if (!m_Recorded.empty())
+    {
+        vkCmdExecuteCommands(primary, (uint32_t)m_Recorded.size(), m_Recorded.data());
+    }
+    vkCmdEndRenderPass(primary);
+}
+
+uint32_t ParallelRecorder::GetThreadCount(void) const noexcept
+{
+    return m_ThreadCount;
+}
+}
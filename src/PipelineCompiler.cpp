@@ -0,0 +1,286 @@
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/PipelineCompiler.hpp"
+
+namespace vks
+{
+VkPipeline PipelineCompiler::Result::Get(void) const noexcept
+{
+    return (Status::Ready == m_Status.load(std::memory_order_acquire)) ? m_Pipeline : VK_NULL_HANDLE;
+}
+
+PipelineCompiler::Status PipelineCompiler::Result::GetStatus(void) const noexcept
+{
+    return m_Status.load(std::memory_order_acquire);
+}
+
+bool PipelineCompiler::Result::IsReady(void) const noexcept
+{
+    return Status::Ready == m_Status.load(std::memory_order_acquire);
+}
+
+/**
+* @param device logical device, its pipeline cache seeds the cache of every worker
+* @param threadCount number of worker threads, by default one less than the cores so the main thread keeps one
+*/
+PipelineCompiler::PipelineCompiler(Device const& device, uint32_t threadCount) noexcept
+    : m_Device(device), m_Pending(0), m_Stop(false)
+{
+    for (uint32_t i = 0; i < std::max(threadCount, 1u); i++)
+    {
+        m_Workers.emplace_back(&PipelineCompiler::WorkerLoop, this);
+    }
+}
+
+/**
+* Pipelines still queued are not compiled, their handles report Failed, the compiled ones are destroyed
+*/
+PipelineCompiler::~PipelineCompiler(void) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_Stop = true;
+        for (auto& job : m_Jobs)
+        {
+            job.pResult->m_Status.store(Status::Failed, std::memory_order_release);
+        }
+        /* the dropped jobs are no longer pending, WaitIdle on another thread returns once the workers are done */
+        m_Pending -= (uint32_t)m_Jobs.size();
+        m_Jobs.clear();
+    }
+    m_WorkCv.notify_all();
+    m_IdleCv.notify_all();
+    for (auto& worker : m_Workers)
+    {
+        worker.join();
+    }
+
+    for (auto& result : m_Results)
+    {
+        if (VK_NULL_HANDLE != result.m_Pipeline)
+        {
+            vkDestroyPipeline(m_Device, result.m_Pipeline, nullptr);
+        }
+    }
+}
+
+/**
+* Create a pipeline, library or link from a description on the calling thread, also used by
+* vks::PipelineStateCache and vks::PipelineLibrary
+*/
+VkResult PipelineCompiler::Create(VkDevice device, GraphicsPipelineDesc const& desc, VkPipelineCache cache, VkPipeline* pPipeline) noexcept
+{
+    std::vector<VkPipelineShaderStageCreateInfo> stages;
+    std::vector<VkSpecializationInfo> specializations(desc.Stages.size());
+    /* linked pipelines take their stages from the libraries */
+    for (size_t i = 0; (i < desc.Stages.size()) && desc.Libraries.empty(); i++)
+    {
+        ShaderStageDesc const& stage = desc.Stages[i];
+        if (0 != desc.LibraryParts)
+        {
+            /* a library only holds the stages of its parts */
+            VkGraphicsPipelineLibraryFlagsEXT part = (VK_SHADER_STAGE_FRAGMENT_BIT == stage.Stage)
+                ? VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT
+                : VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT;
+            if (0 == (desc.LibraryParts & part))
+            {
+                continue;
+            }
+        }
+        stages.push_back(vks::inits::pipelineShaderStageCreateInfo(stage.Stage, stage.Module, stage.EntryPoint.c_str()));
+        if (!stage.SpecializationEntries.empty())
+        {
+            specializations[i] = { (uint32_t)stage.SpecializationEntries.size(), stage.SpecializationEntries.data(),
+                stage.SpecializationData.size(), stage.SpecializationData.data() };
+            stages.back().pSpecializationInfo = &specializations[i];
+        }
+    }
+
+    VkPipelineVertexInputStateCreateInfo vertexInputState =
+        vks::inits::pipelineVertexInputStateCreateInfo(desc.VertexBindings, desc.VertexAttributes);
+    VkPipelineInputAssemblyStateCreateInfo inputAssemblyState =
+        vks::inits::pipelineInputAssemblyStateCreateInfo(desc.Topology, 0, desc.PrimitiveRestart);
+    VkPipelineRasterizationStateCreateInfo rasterizationState =
+        vks::inits::pipelineRasterizationStateCreateInfo(desc.PolygonMode, desc.CullMode, desc.FrontFace);
+    VkPipelineColorBlendStateCreateInfo colorBlendState =
+        vks::inits::pipelineColorBlendStateCreateInfo((uint32_t)desc.BlendAttachments.size(), desc.BlendAttachments.data());
+    VkPipelineDepthStencilStateCreateInfo depthStencilState =
+        vks::inits::pipelineDepthStencilStateCreateInfo(desc.DepthTest, desc.DepthWrite, desc.DepthCompareOp);
+    VkPipelineViewportStateCreateInfo viewportState = vks::inits::pipelineViewportStateCreateInfo(1, 1);
+    VkPipelineMultisampleStateCreateInfo multisampleState = vks::inits::pipelineMultisampleStateCreateInfo(desc.Samples);
+    VkPipelineDynamicStateCreateInfo dynamicState = vks::inits::pipelineDynamicStateCreateInfo(desc.DynamicStates);
+
+    VkGraphicsPipelineCreateInfo pipelineCreateInfo = vks::inits::pipelineCreateInfo(desc.Layout, desc.RenderPass, desc.Flags);
+    pipelineCreateInfo.stageCount = (uint32_t)stages.size();
+    pipelineCreateInfo.pStages = stages.data();
+    pipelineCreateInfo.pVertexInputState = &vertexInputState;
+    pipelineCreateInfo.pInputAssemblyState = &inputAssemblyState;
+    pipelineCreateInfo.pViewportState = &viewportState;
+    pipelineCreateInfo.pRasterizationState = &rasterizationState;
+    pipelineCreateInfo.pMultisampleState = &multisampleState;
+    pipelineCreateInfo.pDepthStencilState = &depthStencilState;
+    pipelineCreateInfo.pColorBlendState = &colorBlendState;
+    pipelineCreateInfo.pDynamicState = &dynamicState;
+    pipelineCreateInfo.subpass = desc.Subpass;
+
+    VkPipelineRenderingCreateInfoKHR renderingCreateInfo = vks::inits::pipelineRenderingCreateInfo();
+    if (VK_NULL_HANDLE == desc.RenderPass)
+    {
+        renderingCreateInfo.colorAttachmentCount = (uint32_t)desc.ColorFormats.size();
+        renderingCreateInfo.pColorAttachmentFormats = desc.ColorFormats.data();
+        renderingCreateInfo.depthAttachmentFormat = desc.DepthFormat;
+        renderingCreateInfo.stencilAttachmentFormat = desc.StencilFormat;
+        pipelineCreateInfo.pNext = &renderingCreateInfo;
+    }
+
+    VkGraphicsPipelineLibraryCreateInfoEXT libraryCreateInfo = vks::inits::graphicsPipelineLibraryCreateInfo(desc.LibraryParts);
+    if (0 != desc.LibraryParts)
+    {
+        libraryCreateInfo.pNext = pipelineCreateInfo.pNext;
+        pipelineCreateInfo.pNext = &libraryCreateInfo;
+        pipelineCreateInfo.flags |= VK_PIPELINE_CREATE_LIBRARY_BIT_KHR;
+    }
+
+    VkPipelineLibraryCreateInfoKHR linkCreateInfo =
+        vks::inits::pipelineLibraryCreateInfo((uint32_t)desc.Libraries.size(), desc.Libraries.data());
+    if (!desc.Libraries.empty())
+    {
+        linkCreateInfo.pNext = pipelineCreateInfo.pNext;
+        pipelineCreateInfo.pNext = &linkCreateInfo;
+    }
+
+    return vkCreateGraphicsPipelines(device, cache, 1, &pipelineCreateInfo, nullptr, pPipeline);
+}
+
+VkResult PipelineCompiler::Create(VkDevice device, ComputePipelineDesc const& desc, VkPipelineCache cache, VkPipeline* pPipeline) noexcept
+{
+    VkComputePipelineCreateInfo pipelineCreateInfo = vks::inits::computePipelineCreateInfo(desc.Layout, desc.Flags);
+    pipelineCreateInfo.stage = vks::inits::pipelineShaderStageCreateInfo(
+        VK_SHADER_STAGE_COMPUTE_BIT, desc.Stage.Module, desc.Stage.EntryPoint.c_str());
+
+    VkSpecializationInfo specialization{};
+    if (!desc.Stage.SpecializationEntries.empty())
+    {
+        specialization = { (uint32_t)desc.Stage.SpecializationEntries.size(), desc.Stage.SpecializationEntries.data(),
+            desc.Stage.SpecializationData.size(), desc.Stage.SpecializationData.data() };
+        pipelineCreateInfo.stage.pSpecializationInfo = &specialization;
+    }
+
+    return vkCreateComputePipelines(device, cache, 1, &pipelineCreateInfo, nullptr, pPipeline);
+}
+
+void PipelineCompiler::WorkerLoop(void) noexcept
+{
+    /* the device owns it and merges it into its own cache when saving */
+    VkPipelineCache cache = m_Device.CreateThreadPipelineCache();
+
+    while (true)
+    {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_Mutex);
+            m_WorkCv.wait(lock, [this] { return m_Stop || !m_Jobs.empty(); });
+            if (m_Stop)
+            {
+                return;
+            }
+            job = std::move(m_Jobs.front());
+            m_Jobs.pop_front();
+        }
+
+        VkPipeline pipeline = VK_NULL_HANDLE;
+        VkResult result = std::visit([&](auto const& desc) { return Create(m_Device, desc, cache, &pipeline); }, job.Desc);
+        if (VK_SUCCESS == result)
+        {
+            job.pResult->m_Pipeline = pipeline;
+            job.pResult->m_Status.store(Status::Ready, std::memory_order_release);
+        }
+        else
+        {
+            spdlog::error("Pipeline compilation failed with {}", vks::utils::statusString(result));
+            job.pResult->m_Status.store(Status::Failed, std::memory_order_release);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            if (0 == --m_Pending)
+            {
+                m_IdleCv.notify_all();
+            }
+        }
+    }
+}
+
+template <typename Desc>
+std::vector<PipelineCompiler::Handle> PipelineCompiler::Enqueue(std::vector<Desc>& descs) noexcept
+{
+    std::vector<Handle> handles;
+    handles.reserve(descs.size());
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        for (auto& desc : descs)
+        {
+            Result& result = m_Results.emplace_back();
+            m_Jobs.push_back({ &result, std::move(desc) });
+            handles.push_back(&result);
+        }
+        m_Pending += (uint32_t)descs.size();
+    }
+    m_WorkCv.notify_all();
+    return handles;
+}
+
+/**
+* Queue a batch of pipelines, compiled in order of submission by the next free workers
+*
+* @return one handle per description, in the same order
+*/
+std::vector<PipelineCompiler::Handle> PipelineCompiler::Compile(std::vector<GraphicsPipelineDesc> descs) noexcept
+{
+    return Enqueue(descs);
+}
+
+std::vector<PipelineCompiler::Handle> PipelineCompiler::Compile(std::vector<ComputePipelineDesc> descs) noexcept
+{
+    return Enqueue(descs);
+}
+
+PipelineCompiler::Handle PipelineCompiler::Compile(GraphicsPipelineDesc desc) noexcept
+{
+    std::vector<GraphicsPipelineDesc> descs;
+    descs.push_back(std::move(desc));
+    return Enqueue(descs).front();
+}
+
+PipelineCompiler::Handle PipelineCompiler::Compile(ComputePipelineDesc desc) noexcept
+{
+    std::vector<ComputePipelineDesc> descs;
+    descs.push_back(std::move(desc));
+    return Enqueue(descs).front();
+}
+
+/**
+* Block until every queued pipeline is compiled, e.g. at the end of a loading screen
+*/
+void PipelineCompiler::WaitIdle(void) noexcept
+{
+    std::unique_lock<std::mutex> lock(m_Mutex);
+    m_IdleCv.wait(lock, [this] { return 0 == m_Pending; });
+}
+
+/**
+* Pipelines queued or being compiled, e.g. for a loading progress bar
+*/
+uint32_t PipelineCompiler::GetPendingCount(void) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return m_Pending;
+}
+
+uint32_t PipelineCompiler::GetThreadCount(void) const noexcept
+{
+    return (uint32_t)m_Workers.size();
+}
+}
@@ -0,0 +1,258 @@
+#include <cstring>
+
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/PipelineLibrary.hpp"
+
+namespace vks
+{
+static constexpr VkGraphicsPipelineLibraryFlagsEXT PART_FLAGS[] = {
+    VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+    VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+};
+
+/**
+* @param device logical device, its pipeline cache is used for the parts and the fast links
+* @param compiler compiles the optimized links, owns them and must outlive the library
+* @param libraryEnabled VK_EXT_graphics_pipeline_library, VK_KHR_pipeline_library and the graphicsPipelineLibrary
+* feature were enabled on the device
+*/
+PipelineLibrary::PipelineLibrary(Device const& device, PipelineCompiler& compiler, bool libraryEnabled) noexcept
+    : m_Device(device), m_Compiler(compiler), m_LibraryEnabled(libraryEnabled)
+{
+    if (m_LibraryEnabled && !device.ExtensionSupported(VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+    {
+        spdlog::warn("{} is not supported, pipelines are created whole", VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME);
+        m_LibraryEnabled = false;
+    }
+}
+
+/**
+* Waits for the compiler to go idle as queued optimized links still use the parts
+*/
+PipelineLibrary::~PipelineLibrary(void) noexcept
+{
+    m_Compiler.WaitIdle();
+    for (auto& entry : m_Entries)
+    {
+        vkDestroyPipeline(m_Device, entry.second.FastLinked, nullptr);
+    }
+    for (auto& parts : m_Parts)
+    {
+        for (auto& part : parts)
+        {
+            vkDestroyPipeline(m_Device, part.second, nullptr);
+        }
+    }
+}
+
+/**
+* Copy the fields of a state a part is built from into a default state, shaders of the fragment part are
+* only the fragment stage and those of the pre-rasterization part every other stage
+*/
+PipelineState PipelineLibrary::GetPartKey(PipelineState const& state, uint32_t part) noexcept
+{
+    PipelineState key;
+
+    if (VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT == PART_FLAGS[part])
+    {
+        std::memcpy(key.VertexBindings, state.VertexBindings, sizeof(state.VertexBindings));
+        std::memcpy(key.VertexAttributes, state.VertexAttributes, sizeof(state.VertexAttributes));
+        key.VertexBindingCount = state.VertexBindingCount;
+        key.VertexAttributeCount = state.VertexAttributeCount;
+        key.Topology = state.Topology;
+        key.PrimitiveRestart = state.PrimitiveRestart;
+        return key;
+    }
+
+    if (VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT == PART_FLAGS[part])
+    {
+        std::memcpy(key.BlendAttachments, state.BlendAttachments, sizeof(state.BlendAttachments));
+        std::memcpy(key.ColorFormats, state.ColorFormats, sizeof(state.ColorFormats));
+        key.ColorAttachmentCount = state.ColorAttachmentCount;
+    }
+    else
+    {
+        bool fragment = (VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT == PART_FLAGS[part]);
+        for (uint32_t i = 0; i < state.StageCount; i++)
+        {
+            if (fragment == (VK_SHADER_STAGE_FRAGMENT_BIT == state.Stages[i]))
+            {
+                key.AddStage(state.Stages[i], state.Modules[i]);
+            }
+        }
+        key.Layout = state.Layout;
+        std::memcpy(key.SpecializationEntries, state.SpecializationEntries, sizeof(state.SpecializationEntries));
+        std::memcpy(key.SpecializationData, state.SpecializationData, sizeof(state.SpecializationData));
+        key.SpecializationEntryCount = state.SpecializationEntryCount;
+        key.SpecializationDataSize = state.SpecializationDataSize;
+    }
+
+    if (VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT == PART_FLAGS[part])
+    {
+        key.PolygonMode = state.PolygonMode;
+        key.CullMode = state.CullMode;
+        key.FrontFace = state.FrontFace;
+    }
+    else
+    {
+        key.Samples = state.Samples;
+        key.DepthFormat = state.DepthFormat;
+        key.StencilFormat = state.StencilFormat;
+    }
+
+    if (VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT == PART_FLAGS[part])
+    {
+        key.DepthTest = state.DepthTest;
+        key.DepthWrite = state.DepthWrite;
+        key.DepthCompareOp = state.DepthCompareOp;
+    }
+
+    /* the last three parts are created against the render pass or attachment formats */
+    key.RenderPass = state.RenderPass;
+    key.Subpass = state.Subpass;
+    std::memcpy(key.DynamicStates, state.DynamicStates, sizeof(state.DynamicStates));
+    key.DynamicStateCount = state.DynamicStateCount;
+    return key;
+}
+
+VkPipeline PipelineLibrary::GetCurrent(Entry const& entry) noexcept
+{
+    return ((nullptr != entry.Optimized) && entry.Optimized->IsReady()) ? entry.Optimized->Get() : entry.FastLinked;
+}
+
+/**
+* Get the library of one part of a state, compiling it on the calling thread the first time it is needed
+* Libraries retain their link time optimization info for the optimized link
+*/
+VkResult PipelineLibrary::GetPart(PipelineState const& state, uint32_t part, VkPipeline* pLibrary) noexcept
+{
+    PipelineState key = GetPartKey(state, part);
+    {
+        std::lock_guard<std::mutex> lock(m_PartMutex);
+        auto it = m_Parts[part].find(key);
+        if (m_Parts[part].end() != it)
+        {
+            *pLibrary = it->second;
+            return VK_SUCCESS;
+        }
+    }
+
+    GraphicsPipelineDesc desc = key.GetDesc();
+    desc.LibraryParts = PART_FLAGS[part];
+    desc.Flags = VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT;
+    VkPipeline library;
+    VkResult result = PipelineCompiler::Create(m_Device, desc, m_Device.GetPipelineCache(), &library);
+    if (VK_SUCCESS != result)
+    {
+        return result;
+    }
+
+    std::lock_guard<std::mutex> lock(m_PartMutex);
+    auto inserted = m_Parts[part].emplace(key, library);
+    if (!inserted.second)
+    {
+        /* another thread compiled the same part meanwhile */
+        vkDestroyPipeline(m_Device, library, nullptr);
+    }
+    *pLibrary = inserted.first->second;
+    return VK_SUCCESS;
+}
+
+/**
+* Get the pipeline of a state, the optimized one once its background link is done, else the fast-linked one
+* Pipelines replaced by their optimized link stay alive until destruction, command buffers may still use them
+*
+* @return the pipeline, owned by the library or its compiler, VK_NULL_HANDLE if its creation failed, which is
+* only tried once
+*/
+VkPipeline PipelineLibrary::Get(PipelineState const& state) noexcept
+{
+    {
+        std::shared_lock<std::shared_mutex> lock(m_EntryMutex);
+        auto it = m_Entries.find(state);
+        if (m_Entries.end() != it)
+        {
+            return GetCurrent(it->second);
+        }
+    }
+
+    GraphicsPipelineDesc desc;
+    VkResult result = VK_SUCCESS;
+    if (m_LibraryEnabled)
+    {
+        /* the link only takes the layout, attachment formats must match those of the parts */
+        desc.Layout = state.Layout;
+        desc.RenderPass = state.RenderPass;
+        desc.Subpass = state.Subpass;
+        desc.ColorFormats.assign(state.ColorFormats, state.ColorFormats + state.ColorAttachmentCount);
+        desc.DepthFormat = state.DepthFormat;
+        desc.StencilFormat = state.StencilFormat;
+        for (uint32_t part = 0; (part < PART_COUNT) && (VK_SUCCESS == result); part++)
+        {
+            VkPipeline library = VK_NULL_HANDLE;
+            result = GetPart(state, part, &library);
+            desc.Libraries.push_back(library);
+        }
+    }
+    else
+    {
+        desc = state.GetDesc();
+    }
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (VK_SUCCESS == result)
+    {
+        result = PipelineCompiler::Create(m_Device, desc, m_Device.GetPipelineCache(), &pipeline);
+    }
+    if (VK_SUCCESS != result)
+    {
+        spdlog::error("Pipeline creation failed with {}", vks::utils::statusString(result));
+        pipeline = VK_NULL_HANDLE;
+    }
+
+    std::unique_lock<std::shared_mutex> lock(m_EntryMutex);
+    auto it = m_Entries.find(state);
+    if (m_Entries.end() != it)
+    {
+        /* another thread created the same state meanwhile, destroying VK_NULL_HANDLE is a no-op */
+        vkDestroyPipeline(m_Device, pipeline, nullptr);
+        return GetCurrent(it->second);
+    }
+
+    /* a failure is recorded as VK_NULL_HANDLE, so the render thread does not retry the parts and link every frame */
+    Entry entry{ pipeline, nullptr };
+    if (m_LibraryEnabled && (VK_NULL_HANDLE != pipeline))
+    {
+        desc.Flags = VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT;
+        entry.Optimized = m_Compiler.Compile(std::move(desc));
+    }
+    m_Entries.emplace(state, entry);
+    return pipeline;
+}
+
+bool PipelineLibrary::IsLibraryEnabled(void) const noexcept
+{
+    return m_LibraryEnabled;
+}
+
+size_t PipelineLibrary::GetPipelineCount(void) noexcept
+{
+    std::shared_lock<std::shared_mutex> lock(m_EntryMutex);
+    return m_Entries.size();
+}
+
+size_t PipelineLibrary::GetPartCount(void) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_PartMutex);
+    size_t count = 0;
+    for (auto& parts : m_Parts)
+    {
+        count += parts.size();
+    }
+    return count;
+}
+}
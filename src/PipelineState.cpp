@@ -0,0 +1,248 @@
+#include <cassert>
+#include <cstring>
+
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/PipelineState.hpp"
+
+namespace vks
+{
+PipelineState& PipelineState::AddStage(VkShaderStageFlagBits stage, VkShaderModule module) noexcept
+{
+    assert(StageCount < MAX_STAGES);
+    Stages[StageCount] = stage;
+    Modules[StageCount] = module;
+    StageCount++;
+    return *this;
+}
+
+PipelineState& PipelineState::AddVertexBinding(uint32_t binding, uint32_t stride, VkVertexInputRate inputRate) noexcept
+{
+    assert(VertexBindingCount < MAX_VERTEX_BINDINGS);
+    VertexBindings[VertexBindingCount++] = { binding, stride, inputRate };
+    return *this;
+}
+
+PipelineState& PipelineState::AddVertexAttribute(uint32_t location, uint32_t binding, VkFormat format, uint32_t offset) noexcept
+{
+    assert(VertexAttributeCount < MAX_VERTEX_ATTRIBUTES);
+    VertexAttributes[VertexAttributeCount++] = { location, binding, format, offset };
+    return *this;
+}
+
+PipelineState& PipelineState::AddColorAttachment(VkFormat format, VkPipelineColorBlendAttachmentState const& blend) noexcept
+{
+    assert(ColorAttachmentCount < MAX_COLOR_ATTACHMENTS);
+    ColorFormats[ColorAttachmentCount] = format;
+    BlendAttachments[ColorAttachmentCount] = blend;
+    ColorAttachmentCount++;
+    return *this;
+}
+
+/**
+* Add an opaque color attachment writing every component
+*/
+PipelineState& PipelineState::AddColorAttachment(VkFormat format) noexcept
+{
+    VkPipelineColorBlendAttachmentState blend{};
+    blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    return AddColorAttachment(format, blend);
+}
+
+PipelineState& PipelineState::AddDynamicState(VkDynamicState dynamicState) noexcept
+{
+    assert(DynamicStateCount < MAX_DYNAMIC_STATES);
+    DynamicStates[DynamicStateCount++] = dynamicState;
+    return *this;
+}
+
+/**
+* 64-bit multiply-xorshift over the state's words, the state is a multiple of 8 bytes
+*/
+size_t PipelineState::Hash(void) const noexcept
+{
+    static_assert(0 == sizeof(PipelineState) % sizeof(uint64_t));
+    uint64_t const* pWords = reinterpret_cast<uint64_t const*>(this);
+    uint64_t hash = sizeof(PipelineState);
+    for (size_t i = 0; i < sizeof(PipelineState) / sizeof(uint64_t); i++)
+    {
+        hash = (hash ^ pWords[i]) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 32;
+    }
+    return (size_t)hash;
+}
+
+bool PipelineState::operator==(PipelineState const& other) const noexcept
+{
+    return 0 == std::memcmp(this, &other, sizeof(PipelineState));
+}
+
+/**
+* Expand the state into an owning description, e.g. to compile it with vks::PipelineCompiler
+*/
+GraphicsPipelineDesc PipelineState::GetDesc(void) const noexcept
+{
+    GraphicsPipelineDesc desc;
+    for (uint32_t i = 0; i < StageCount; i++)
+    {
+        desc.Stages.push_back({ Stages[i], Modules[i] });
+        desc.Stages.back().SpecializationEntries.assign(SpecializationEntries, SpecializationEntries + SpecializationEntryCount);
+        desc.Stages.back().SpecializationData.assign(SpecializationData, SpecializationData + SpecializationDataSize);
+    }
+    desc.VertexBindings.assign(VertexBindings, VertexBindings + VertexBindingCount);
+    desc.VertexAttributes.assign(VertexAttributes, VertexAttributes + VertexAttributeCount);
+    desc.Topology = Topology;
+    desc.PrimitiveRestart = PrimitiveRestart;
+    desc.PolygonMode = PolygonMode;
+    desc.CullMode = CullMode;
+    desc.FrontFace = FrontFace;
+    desc.Samples = Samples;
+    desc.DepthTest = DepthTest;
+    desc.DepthWrite = DepthWrite;
+    desc.DepthCompareOp = DepthCompareOp;
+    desc.BlendAttachments.assign(BlendAttachments, BlendAttachments + ColorAttachmentCount);
+    desc.DynamicStates.assign(DynamicStates, DynamicStates + DynamicStateCount);
+    desc.Layout = Layout;
+    desc.RenderPass = RenderPass;
+    desc.Subpass = Subpass;
+    desc.ColorFormats.assign(ColorFormats, ColorFormats + ColorAttachmentCount);
+    desc.DepthFormat = DepthFormat;
+    desc.StencilFormat = StencilFormat;
+    return desc;
+}
+
+/**
+* @param initialCapacity pipelines the table holds before it first grows, rounded up to a power of two
+*/
+PipelineStateCache::PipelineStateCache(Device const& device, uint32_t initialCapacity) noexcept
+    : m_Device(device)
+{
+    size_t capacity = 16;
+    while (capacity < 2 * (size_t)initialCapacity)
+    {
+        capacity *= 2;
+    }
+    Table* pTable = new Table{ capacity - 1, new std::atomic<Entry*>[capacity]() };
+    m_Tables.push_back(pTable);
+    m_pTable.store(pTable, std::memory_order_release);
+}
+
+PipelineStateCache::~PipelineStateCache(void) noexcept
+{
+    for (Entry* pEntry : m_Entries)
+    {
+        vkDestroyPipeline(m_Device, pEntry->Pipeline, nullptr);
+        delete pEntry;
+    }
+    for (Table* pTable : m_Tables)
+    {
+        delete[] pTable->pSlots;
+        delete pTable;
+    }
+}
+
+PipelineStateCache::Entry* PipelineStateCache::Probe(Table const* pTable, PipelineState const& state, size_t hash) noexcept
+{
+    for (size_t i = hash & pTable->Mask;; i = (i + 1) & pTable->Mask)
+    {
+        Entry* pEntry = pTable->pSlots[i].load(std::memory_order_acquire);
+        if (nullptr == pEntry)
+        {
+            return nullptr;
+        }
+        if ((pEntry->Hash == hash) && (pEntry->State == state))
+        {
+            return pEntry;
+        }
+    }
+}
+
+/**
+* Publish an entry, the caller holds m_InsertMutex
+* The table is kept at most half full so probes stay short and always reach an empty slot
+*/
+void PipelineStateCache::Insert(Entry* pEntry) noexcept
+{
+    Table* pTable = m_pTable.load(std::memory_order_relaxed);
+    if (2 * (m_Entries.size() + 1) > pTable->Mask + 1)
+    {
+        size_t capacity = 2 * (pTable->Mask + 1);
+        Table* pGrown = new Table{ capacity - 1, new std::atomic<Entry*>[capacity]() };
+        for (Entry* pOld : m_Entries)
+        {
+            size_t i = pOld->Hash & pGrown->Mask;
+            while (nullptr != pGrown->pSlots[i].load(std::memory_order_relaxed))
+            {
+                i = (i + 1) & pGrown->Mask;
+            }
+            pGrown->pSlots[i].store(pOld, std::memory_order_relaxed);
+        }
+        m_Tables.push_back(pGrown);
+        m_pTable.store(pGrown, std::memory_order_release);
+        pTable = pGrown;
+    }
+
+    size_t i = pEntry->Hash & pTable->Mask;
+    while (nullptr != pTable->pSlots[i].load(std::memory_order_relaxed))
+    {
+        i = (i + 1) & pTable->Mask;
+    }
+    pTable->pSlots[i].store(pEntry, std::memory_order_release);
+    m_Entries.push_back(pEntry);
+}
+
+/**
+* Look a pipeline up without creating it, a state whose creation failed is found as VK_NULL_HANDLE
+*/
+std::optional<VkPipeline> PipelineStateCache::Find(PipelineState const& state) const noexcept
+{
+    Entry const* pEntry = Probe(m_pTable.load(std::memory_order_acquire), state, state.Hash());
+    if (nullptr == pEntry)
+    {
+        return std::nullopt;
+    }
+    return pEntry->Pipeline;
+}
+
+/**
+* Get the pipeline of a state, creating it on the calling thread the first time the state is seen
+*
+* @return the pipeline, owned by the cache, VK_NULL_HANDLE if its creation failed, which is only tried once
+*/
+VkPipeline PipelineStateCache::Get(PipelineState const& state) noexcept
+{
+    size_t hash = state.Hash();
+    Entry const* pFound = Probe(m_pTable.load(std::memory_order_acquire), state, hash);
+    if (nullptr != pFound)
+    {
+        return pFound->Pipeline;
+    }
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    VkResult result = PipelineCompiler::Create(m_Device, state.GetDesc(), m_Device.GetPipelineCache(), &pipeline);
+    if (VK_SUCCESS != result)
+    {
+        /* the failure is cached too, so the state is not created again and again every frame */
+        spdlog::error("Pipeline creation failed with {}", vks::utils::statusString(result));
+        pipeline = VK_NULL_HANDLE;
+    }
+
+    std::lock_guard<std::mutex> lock(m_InsertMutex);
+    pFound = Probe(m_pTable.load(std::memory_order_relaxed), state, hash);
+    if (nullptr != pFound)
+    {
+        /* another thread created the same state meanwhile, destroying VK_NULL_HANDLE is a no-op */
+        vkDestroyPipeline(m_Device, pipeline, nullptr);
+        return pFound->Pipeline;
+    }
+    Insert(new Entry{ state, hash, pipeline });
+    return pipeline;
+}
+
+size_t PipelineStateCache::GetPipelineCount(void) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_InsertMutex);
+    return m_Entries.size();
+}
+}
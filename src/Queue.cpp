@@ -0,0 +1,269 @@
+#include <algorithm>
+#include <vector>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/Queue.hpp"
+
+namespace vks
+{
+/* device level, loaded by the first Queue since the application targets Vulkan 1.0 */
+static PFN_vkGetSemaphoreCounterValueKHR vkGetSemaphoreCounterValueKHR = nullptr;
+static PFN_vkWaitSemaphoresKHR vkWaitSemaphoresKHR = nullptr;
+
+bool GpuFuture::IsReady(void) const noexcept
+{
+    return !m_pQueue || (m_pQueue->GetCompletedValue() >= m_Value);
+}
+
+/**
+* Block until the submit has finished
+*
+* @return VK_SUCCESS once complete, VK_TIMEOUT if the timeout expired first
+*/
+VkResult GpuFuture::Wait(uint64_t timeout) const noexcept
+{
+    if (!m_pQueue)
+    {
+        return VK_SUCCESS;
+    }
+    return m_pQueue->WaitValue(m_Value, timeout);
+}
+
+/**
+* Run a callback on the thread calling Queue::Poll once the submit has finished
+*/
+void GpuFuture::Then(std::function<void(void)> callback) const noexcept
+{
+    if (!m_pQueue)
+    {
+        callback();
+        return;
+    }
+    m_pQueue->AddCallback(m_Value, std::move(callback));
+}
+
+VkSemaphore GpuFuture::GetSemaphore(void) const noexcept
+{
+    return m_pQueue ? m_pQueue->GetTimeline() : VK_NULL_HANDLE;
+}
+
+uint64_t GpuFuture::GetValue(void) const noexcept
+{
+    return m_Value;
+}
+
+/**
+* @param device logical device, created with VK_KHR_timeline_semaphore enabled
+* @param familyIndex queue family, one of device.QueueIndex
+* @param queueIndex index of the queue inside the family
+*/
+Queue::Queue(Device const& device, uint32_t familyIndex, uint32_t queueIndex) noexcept
+    : m_Device(device), m_FamilyIndex(familyIndex), m_NextValue(1), m_CompletedValue(0)
+{
+    vkGetDeviceQueue(device, familyIndex, queueIndex, &m_Handle);
+
+    vkGetSemaphoreCounterValueKHR =
+        reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(vkGetDeviceProcAddr(device, "vkGetSemaphoreCounterValueKHR"));
+    vkWaitSemaphoresKHR = reinterpret_cast<PFN_vkWaitSemaphoresKHR>(vkGetDeviceProcAddr(device, "vkWaitSemaphoresKHR"));
+    if (!vkGetSemaphoreCounterValueKHR || !vkWaitSemaphoresKHR)
+    {
+        vks::utils::exitFatal("VK_KHR_timeline_semaphore is not enabled on the device", -1);
+    }
+
+    VkSemaphoreTypeCreateInfo typeInfo{};
+    typeInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+    typeInfo.initialValue = 0;
+    VkSemaphoreCreateInfo semaphoreInfo = vks::inits::semaphoreCreateInfo();
+    semaphoreInfo.pNext = &typeInfo;
+    VK_CHK(vkCreateSemaphore(device, &semaphoreInfo, nullptr, &m_Timeline));
+}
+
+Queue::~Queue(void) noexcept
+{
+    WaitIdle();
+    Poll();
+    vkDestroySemaphore(m_Device, m_Timeline, nullptr);
+}
+
+/**
+* Submit command buffers without waiting for them
+*
+* @param cmdBuffers command buffers of this queue's family, may be empty to only signal
+* @param waitFutures submits of any queue of the device that have to finish first
+* @param waitSemaphores binary semaphores to wait on, e.g. swapchain image acquisition
+* @param waitStages one stage mask per future then per binary semaphore, every wait blocks all commands when empty
+* @param signalSemaphores binary semaphores to signal, e.g. for presentation
+*
+* @return future of this submit
+*/
+GpuFuture Queue::Submit(
+    std::span<const VkCommandBuffer> cmdBuffers,
+    std::span<const GpuFuture> waitFutures,
+    std::span<const VkSemaphore> waitSemaphores,
+    std::span<const VkPipelineStageFlags> waitStages,
+    std::span<const VkSemaphore> signalSemaphores
+) noexcept
+{
+    assert(waitStages.empty() || (waitStages.size() == waitFutures.size() + waitSemaphores.size()));
+
+    /* binary semaphores take a value too, it is ignored */
+    std::vector<VkSemaphore> waits;
+    std::vector<uint64_t> waitValues;
+    for (auto const& future : waitFutures)
+    {
+        if (future)
+        {
+            waits.push_back(future.GetSemaphore());
+            waitValues.push_back(future.GetValue());
+        }
+    }
+    waits.insert(waits.end(), waitSemaphores.begin(), waitSemaphores.end());
+    waitValues.resize(waits.size(), 0);
+
+    std::vector<VkPipelineStageFlags> stages;
+    if (waitStages.empty())
+    {
+        stages.resize(waits.size(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+    else
+    {
+        for (size_t i = 0; i < waitFutures.size(); i++)
+        {
+            if (waitFutures[i])
+            {
+                stages.push_back(waitStages[i]);
+            }
+        }
+        stages.insert(stages.end(), waitStages.begin() + waitFutures.size(), waitStages.end());
+    }
+
+    std::vector<VkSemaphore> signals(signalSemaphores.begin(), signalSemaphores.end());
+    std::vector<uint64_t> signalValues(signals.size(), 0);
+    signals.push_back(m_Timeline);
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    uint64_t value = m_NextValue++;
+    signalValues.push_back(value);
+
+    VkTimelineSemaphoreSubmitInfo timelineInfo{};
+    timelineInfo.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+    timelineInfo.waitSemaphoreValueCount = (uint32_t)waitValues.size();
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    timelineInfo.signalSemaphoreValueCount = (uint32_t)signalValues.size();
+    timelineInfo.pSignalSemaphoreValues = signalValues.data();
+
+    VkSubmitInfo submitInfo = vks::inits::submitInfo();
+    submitInfo.pNext = &timelineInfo;
+    submitInfo.waitSemaphoreCount = (uint32_t)waits.size();
+    submitInfo.pWaitSemaphores = waits.data();
+    submitInfo.pWaitDstStageMask = stages.data();
+    submitInfo.commandBufferCount = (uint32_t)cmdBuffers.size();
+    submitInfo.pCommandBuffers = cmdBuffers.data();
+    submitInfo.signalSemaphoreCount = (uint32_t)signals.size();
+    submitInfo.pSignalSemaphores = signals.data();
+    VK_CHK(vkQueueSubmit(m_Handle, 1, &submitInfo, VK_NULL_HANDLE));
+
+    return GpuFuture(this, value);
+}
+
+/**
+* Highest value of the timeline known to be signaled, every submit up to it has finished
+*/
+uint64_t Queue::GetCompletedValue(void) noexcept
+{
+    uint64_t value;
+    VK_CHK(vkGetSemaphoreCounterValueKHR(m_Device, m_Timeline, &value));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_CompletedValue = std::max(m_CompletedValue, value);
+    return m_CompletedValue;
+}
+
+/**
+* Block until the timeline reaches a value
+*
+* @return VK_SUCCESS once reached, VK_TIMEOUT if the timeout expired first
+*/
+VkResult Queue::WaitValue(uint64_t value, uint64_t timeout) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        if (value <= m_CompletedValue)
+        {
+            return VK_SUCCESS;
+        }
+    }
+
+    VkSemaphoreWaitInfo waitInfo{};
+    waitInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_Timeline;
+    waitInfo.pValues = &value;
+    VkResult result = vkWaitSemaphoresKHR(m_Device, &waitInfo, timeout);
+    if (VK_SUCCESS == result)
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        m_CompletedValue = std::max(m_CompletedValue, value);
+    }
+    return result;
+}
+
+void Queue::AddCallback(uint64_t value, std::function<void(void)> callback) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Callbacks.emplace(value, std::move(callback));
+}
+
+/**
+* Run the callbacks of every finished submit, in submission order
+* Callbacks run without the queue lock held, so they may submit or add callbacks themselves
+*/
+void Queue::Poll(void) noexcept
+{
+    uint64_t completed = GetCompletedValue();
+
+    std::vector<std::function<void(void)>> ready;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto end = m_Callbacks.upper_bound(completed);
+        for (auto it = m_Callbacks.begin(); it != end; it++)
+        {
+            ready.push_back(std::move(it->second));
+        }
+        m_Callbacks.erase(m_Callbacks.begin(), end);
+    }
+
+    for (auto& callback : ready)
+    {
+        callback();
+    }
+}
+
+/**
+* Block until every submit made so far has finished
+*/
+VkResult Queue::WaitIdle(void) noexcept
+{
+    uint64_t last;
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        last = m_NextValue - 1;
+    }
+    return WaitValue(last, UINT64_MAX);
+}
+
+VkSemaphore Queue::GetTimeline(void) const noexcept
+{
+    return m_Timeline;
+}
+
+uint32_t Queue::GetFamilyIndex(void) const noexcept
+{
+    return m_FamilyIndex;
+}
+}
@@ -0,0 +1,667 @@
+#include <algorithm>
+#include <queue>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/RenderGraph.hpp"
+
+namespace vks
+{
+namespace
+{
+struct UsageInfo
+{
+    VkPipelineStageFlags Stages;
+    VkAccessFlags Access;
+    VkImageLayout Layout;
+    VkImageUsageFlags ImageUsage;
+};
+
+constexpr VkPipelineStageFlags SHADER_STAGES =
+    VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+constexpr VkPipelineStageFlags DEPTH_STAGES =
+    VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+constexpr VkAccessFlags WRITE_ACCESS =
+    VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
+UsageInfo GetUsageInfo(ResourceUsage usage) noexcept
+{
+    switch (usage)
+    {
+    case ResourceUsage::ColorAttachment:
+        return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+            VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+    case ResourceUsage::DepthStencilAttachment:
+        return { DEPTH_STAGES,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+    case ResourceUsage::DepthStencilRead:
+        return { DEPTH_STAGES | SHADER_STAGES,
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT };
+    case ResourceUsage::InputAttachment:
+        return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT };
+    case ResourceUsage::ShaderRead:
+        return { SHADER_STAGES, VK_ACCESS_SHADER_READ_BIT,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_USAGE_SAMPLED_BIT };
+    case ResourceUsage::ShaderWrite:
+        return { SHADER_STAGES, VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_USAGE_STORAGE_BIT };
+    case ResourceUsage::TransferSrc:
+        return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+    case ResourceUsage::TransferDst:
+        return { VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_USAGE_TRANSFER_DST_BIT };
+    case ResourceUsage::Present:
+        return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0 };
+    case ResourceUsage::VertexBuffer:
+        return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+    case ResourceUsage::IndexBuffer:
+        return { VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+    case ResourceUsage::UniformBuffer:
+        return { SHADER_STAGES, VK_ACCESS_UNIFORM_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+    case ResourceUsage::IndirectBuffer:
+        return { VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT, VK_IMAGE_LAYOUT_UNDEFINED, 0 };
+    }
+    return { VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT, VK_IMAGE_LAYOUT_GENERAL, 0 };
+}
+
+VkImageAspectFlags GetFormatAspect(VkFormat format) noexcept
+{
+    switch (format)
+    {
+    case VK_FORMAT_D16_UNORM:
+    case VK_FORMAT_X8_D24_UNORM_PACK32:
+    case VK_FORMAT_D32_SFLOAT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT;
+    case VK_FORMAT_S8_UINT:
+        return VK_IMAGE_ASPECT_STENCIL_BIT;
+    case VK_FORMAT_D16_UNORM_S8_UINT:
+    case VK_FORMAT_D24_UNORM_S8_UINT:
+    case VK_FORMAT_D32_SFLOAT_S8_UINT:
+        return VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT;
+    default:
+        return VK_IMAGE_ASPECT_COLOR_BIT;
+    }
+}
+
+/* what the GPU last did to a resource while barriers are computed */
+struct ResourceState
+{
+    VkPipelineStageFlags WriteStages{ 0 };
+    VkAccessFlags WriteAccess{ 0 };
+    /* stages that read since the last write, and the accesses the last write was made visible to */
+    VkPipelineStageFlags ReadStages{ 0 };
+    VkAccessFlags ReadAccess{ 0 };
+    VkImageLayout Layout{ VK_IMAGE_LAYOUT_UNDEFINED };
+};
+}
+
+RenderGraph::RenderGraph(Device const& device) noexcept
+    : m_Device(device)
+{
+}
+
+RenderGraph::~RenderGraph(void) noexcept
+{
+    DestroyTransients();
+}
+
+/**
+* Declare an image owned outside the graph, e.g. a swapchain image
+*
+* @param initialLayout layout the image is in when Execute starts
+* @param finalLayout layout the image is left in when Execute ends, UNDEFINED keeps the last used layout
+*/
+RenderGraph::ResourceId RenderGraph::ImportImage(
+    std::string const& name,
+    VkImage image,
+    VkImageView view,
+    VkImageAspectFlags aspect,
+    VkImageLayout initialLayout,
+    VkImageLayout finalLayout
+) noexcept
+{
+    Resource resource{};
+    resource.Name = name;
+    resource.IsImage = true;
+    resource.Imported = true;
+    resource.Image = image;
+    resource.View = view;
+    resource.Aspect = aspect;
+    resource.InitialLayout = initialLayout;
+    resource.FinalLayout = finalLayout;
+    m_Resources.push_back(std::move(resource));
+    return (ResourceId)m_Resources.size() - 1;
+}
+
+RenderGraph::ResourceId RenderGraph::ImportBuffer(std::string const& name, VkBuffer buffer) noexcept
+{
+    Resource resource{};
+    resource.Name = name;
+    resource.IsImage = false;
+    resource.Imported = true;
+    resource.Buffer = buffer;
+    m_Resources.push_back(std::move(resource));
+    return (ResourceId)m_Resources.size() - 1;
+}
+
+/**
+* Declare a transient 2D image created by Compile, its usage flags come from the passes using it
+* Contents do not survive between frames, the memory may be shared with other transient images
+*/
+RenderGraph::ResourceId RenderGraph::CreateImage(
+    std::string const& name,
+    VkFormat format,
+    VkExtent2D extent,
+    VkSampleCountFlagBits samples
+) noexcept
+{
+    Resource resource{};
+    resource.Name = name;
+    resource.IsImage = true;
+    resource.Imported = false;
+    resource.Aspect = GetFormatAspect(format);
+    resource.CreateInfo = vks::inits::imageCreateInfo(
+        (VkImageCreateFlags)0, VK_IMAGE_TYPE_2D, format, samples, VK_IMAGE_TILING_OPTIMAL, 0);
+    resource.CreateInfo.extent = { extent.width, extent.height, 1 };
+    resource.CreateInfo.mipLevels = 1;
+    resource.CreateInfo.arrayLayers = 1;
+    m_Resources.push_back(std::move(resource));
+    return (ResourceId)m_Resources.size() - 1;
+}
+
+/**
+* Swap the handles of an imported image, e.g. to the swapchain image acquired for this frame
+*/
+void RenderGraph::SetImportedImage(ResourceId id, VkImage image, VkImageView view) noexcept
+{
+    assert(m_Resources[id].Imported && m_Resources[id].IsImage);
+    m_Resources[id].Image = image;
+    m_Resources[id].View = view;
+}
+
+void RenderGraph::SetImportedBuffer(ResourceId id, VkBuffer buffer) noexcept
+{
+    assert(m_Resources[id].Imported && !m_Resources[id].IsImage);
+    m_Resources[id].Buffer = buffer;
+}
+
+/**
+* Keep every pass contributing to a resource, imported resources written by a pass are outputs already
+*/
+void RenderGraph::MarkOutput(ResourceId id) noexcept
+{
+    m_Resources[id].Output = true;
+}
+
+/**
+* @param execute records the pass, resources are looked up through the graph argument
+* @param sideEffect never cull the pass, for passes with effects the graph does not see
+*/
+RenderGraph::PassId RenderGraph::AddPass(std::string const& name, ExecuteFunc execute, bool sideEffect) noexcept
+{
+    Pass pass{};
+    pass.Name = name;
+    pass.Execute = std::move(execute);
+    pass.SideEffect = sideEffect;
+    m_Passes.push_back(std::move(pass));
+    return (PassId)m_Passes.size() - 1;
+}
+
+void RenderGraph::Read(PassId pass, ResourceId resource, ResourceUsage usage) noexcept
+{
+    m_Passes[pass].Accesses.push_back({ resource, usage, false });
+}
+
+void RenderGraph::Write(PassId pass, ResourceId resource, ResourceUsage usage) noexcept
+{
+    m_Passes[pass].Accesses.push_back({ resource, usage, true });
+}
+
+/**
+* Walk the passes backwards from the outputs, a pass is kept when it writes something a kept pass reads
+*/
+void RenderGraph::Cull(std::vector<bool>& kept) const noexcept
+{
+    std::vector<bool> live(m_Resources.size(), false);
+    for (size_t i = 0; i < m_Resources.size(); i++)
+    {
+        live[i] = m_Resources[i].Output || m_Resources[i].Imported;
+    }
+
+    kept.assign(m_Passes.size(), false);
+    for (size_t p = m_Passes.size(); p-- > 0;)
+    {
+        Pass const& pass = m_Passes[p];
+        bool needed = pass.SideEffect;
+        for (auto const& access : pass.Accesses)
+        {
+            needed |= access.Write && live[access.Resource];
+        }
+        if (!needed)
+        {
+            continue;
+        }
+        kept[p] = true;
+        /* writes stay live too, the pass may only update part of the resource */
+        for (auto const& access : pass.Accesses)
+        {
+            live[access.Resource] = true;
+        }
+    }
+}
+
+/**
+* Order the kept passes so every pass comes after the passes it depends on
+* Ready passes are taken in declaration order, so independent passes keep the order they were added in
+*/
+void RenderGraph::Sort(std::vector<bool> const& kept) noexcept
+{
+    std::vector<std::vector<PassId>> edges(m_Passes.size());
+    std::vector<uint32_t> inDegree(m_Passes.size(), 0);
+
+    auto addEdge = [&](PassId from, PassId to) {
+        if ((from != to) && (edges[from].end() == std::find(edges[from].begin(), edges[from].end(), to)))
+        {
+            edges[from].push_back(to);
+            inDegree[to]++;
+        }
+    };
+
+    /* read after write, write after write and write after read, per resource in declaration order */
+    std::vector<PassId> lastWriter(m_Resources.size(), UINT32_MAX);
+    std::vector<std::vector<PassId>> readers(m_Resources.size());
+    for (PassId p = 0; p < m_Passes.size(); p++)
+    {
+        if (!kept[p])
+        {
+            continue;
+        }
+        for (auto const& access : m_Passes[p].Accesses)
+        {
+            ResourceId r = access.Resource;
+            if (UINT32_MAX != lastWriter[r])
+            {
+                addEdge(lastWriter[r], p);
+            }
+            if (access.Write)
+            {
+                for (PassId reader : readers[r])
+                {
+                    addEdge(reader, p);
+                }
+                readers[r].clear();
+                lastWriter[r] = p;
+            }
+            else
+            {
+                readers[r].push_back(p);
+            }
+        }
+    }
+
+    std::priority_queue<PassId, std::vector<PassId>, std::greater<PassId>> ready;
+    for (PassId p = 0; p < m_Passes.size(); p++)
+    {
+        if (kept[p] && (0 == inDegree[p]))
+        {
+            ready.push(p);
+        }
+    }
+
+    m_Order.clear();
+    while (!ready.empty())
+    {
+        PassId p = ready.top();
+        ready.pop();
+        m_Order.push_back(p);
+        for (PassId next : edges[p])
+        {
+            if (0 == --inDegree[next])
+            {
+                ready.push(next);
+            }
+        }
+    }
+}
+
+/**
+* Track the state of every resource through the sorted passes and collect the barriers each pass needs
+* All barriers of a pass are merged into one batch, transient images that reuse memory wait on the
+* last accesses of the previous image in the same memory. Every frame in flight uses the same transient
+* memory, so the passes are walked twice: the first walk only leaves each slot in its state at the end
+* of a frame, which the first image in the slot then waits on, ordering it after the previous frame
+*/
+void RenderGraph::ComputeBarriers(void) noexcept
+{
+    std::vector<ResourceState> states(m_Resources.size());
+
+    /* stages and writes of the last image that used each memory slot */
+    std::vector<ResourceState> slotStates(m_MemorySlots.size());
+
+    for (uint32_t walk = 0; walk < 2; walk++)
+    {
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            states[i] = ResourceState{};
+            states[i].Layout = m_Resources[i].InitialLayout;
+        }
+
+        for (PassId p : m_Order)
+        {
+            Pass& pass = m_Passes[p];
+            BarrierBatch& batch = pass.Before;
+            batch = BarrierBatch{};
+
+            for (auto const& access : pass.Accesses)
+            {
+                Resource const& resource = m_Resources[access.Resource];
+                ResourceState& state = states[access.Resource];
+                UsageInfo info = GetUsageInfo(access.Usage);
+
+                if (!resource.Imported && (resource.FirstUse == p) && (SIZE_MAX != resource.MemorySlot))
+                {
+                    /* the previous occupant's writes and reads must be done before the memory is reused */
+                    ResourceState const& slot = slotStates[resource.MemorySlot];
+                    state.WriteStages = slot.WriteStages | slot.ReadStages;
+                    state.WriteAccess = slot.WriteAccess;
+                }
+
+                VkImageLayout layout = resource.IsImage ? info.Layout : VK_IMAGE_LAYOUT_UNDEFINED;
+                bool layoutChange = resource.IsImage && (layout != state.Layout);
+                bool hazard = access.Write || layoutChange ||
+                    ((0 != state.WriteAccess) && (((state.ReadStages & info.Stages) != info.Stages) || ((state.ReadAccess & info.Access) != info.Access)));
+
+                if (hazard)
+                {
+                    /* writes wait for earlier reads too, reads only for the last write */
+                    VkPipelineStageFlags srcStages = state.WriteStages | ((access.Write || layoutChange) ? state.ReadStages : 0);
+                    batch.SrcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                    batch.DstStages |= info.Stages ? info.Stages : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+                    if (resource.IsImage || (0 != state.WriteAccess))
+                    {
+                        batch.Barriers.push_back({ access.Resource, state.WriteAccess, info.Access, state.Layout, layout });
+                    }
+                }
+
+                if (access.Write)
+                {
+                    state.WriteStages = info.Stages;
+                    state.WriteAccess = info.Access & WRITE_ACCESS;
+                    state.ReadStages = 0;
+                    state.ReadAccess = 0;
+                }
+                else if (hazard && layoutChange)
+                {
+                    /* the layout transition is a write, only this access has seen it */
+                    state.WriteStages = info.Stages;
+                    state.WriteAccess = 0;
+                    state.ReadStages = info.Stages;
+                    state.ReadAccess = info.Access;
+                }
+                else
+                {
+                    state.ReadStages |= info.Stages;
+                    state.ReadAccess |= info.Access;
+                }
+                state.Layout = layout;
+
+                if (!resource.Imported && (SIZE_MAX != resource.MemorySlot))
+                {
+                    slotStates[resource.MemorySlot] = state;
+                }
+            }
+        }
+    }
+
+    /* leave imported images in the layout their owner expects */
+    m_Final = BarrierBatch{};
+    for (ResourceId r = 0; r < m_Resources.size(); r++)
+    {
+        Resource const& resource = m_Resources[r];
+        ResourceState const& state = states[r];
+        if (!resource.Imported || !resource.IsImage || (VK_IMAGE_LAYOUT_UNDEFINED == resource.FinalLayout) ||
+            (resource.FinalLayout == state.Layout))
+        {
+            continue;
+        }
+        VkPipelineStageFlags srcStages = state.WriteStages | state.ReadStages;
+        m_Final.SrcStages |= srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        m_Final.DstStages |= VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+        m_Final.Barriers.push_back({ r, state.WriteAccess, 0, state.Layout, resource.FinalLayout });
+    }
+}
+
+/**
+* Create the used transient images and place them in shared memory
+* Largest images are placed first, each goes to the first slot of compatible memory whose images
+* are all dead before it is first used or born after it is last used
+*/
+void RenderGraph::CreateTransients(void) noexcept
+{
+    std::vector<ResourceId> transients;
+    for (ResourceId r = 0; r < m_Resources.size(); r++)
+    {
+        Resource& resource = m_Resources[r];
+        resource.FirstUse = UINT32_MAX;
+        resource.LastUse = 0;
+        resource.MemorySlot = SIZE_MAX;
+        resource.CreateInfo.usage = 0;
+    }
+
+    for (uint32_t i = 0; i < m_Order.size(); i++)
+    {
+        for (auto const& access : m_Passes[m_Order[i]].Accesses)
+        {
+            Resource& resource = m_Resources[access.Resource];
+            resource.FirstUse = std::min(resource.FirstUse, i);
+            resource.LastUse = std::max(resource.LastUse, i);
+            resource.CreateInfo.usage |= GetUsageInfo(access.Usage).ImageUsage;
+        }
+    }
+
+    std::vector<VkMemoryRequirements> memReqs(m_Resources.size());
+    for (ResourceId r = 0; r < m_Resources.size(); r++)
+    {
+        Resource& resource = m_Resources[r];
+        if (resource.Imported || (UINT32_MAX == resource.FirstUse))
+        {
+            continue;
+        }
+        VK_CHK(vkCreateImage(m_Device, &resource.CreateInfo, nullptr, &resource.Image));
+        vkGetImageMemoryRequirements(m_Device, resource.Image, &memReqs[r]);
+        transients.push_back(r);
+    }
+
+    std::stable_sort(transients.begin(), transients.end(),
+        [&memReqs](ResourceId a, ResourceId b) { return memReqs[a].size > memReqs[b].size; });
+
+    for (ResourceId r : transients)
+    {
+        Resource& resource = m_Resources[r];
+        VkMemoryRequirements const& reqs = memReqs[r];
+
+        size_t slotIndex = 0;
+        for (; slotIndex < m_MemorySlots.size(); slotIndex++)
+        {
+            MemorySlot const& slot = m_MemorySlots[slotIndex];
+            if (0 == (slot.Requirements.memoryTypeBits & reqs.memoryTypeBits))
+            {
+                continue;
+            }
+            bool overlaps = std::any_of(slot.Lifetimes.begin(), slot.Lifetimes.end(), [&resource](auto const& lifetime) {
+                return (resource.FirstUse <= lifetime.second) && (lifetime.first <= resource.LastUse);
+            });
+            if (!overlaps)
+            {
+                break;
+            }
+        }
+        if (slotIndex == m_MemorySlots.size())
+        {
+            m_MemorySlots.push_back({ reqs, {}, {} });
+        }
+
+        MemorySlot& slot = m_MemorySlots[slotIndex];
+        slot.Requirements.size = std::max(slot.Requirements.size, reqs.size);
+        slot.Requirements.alignment = std::max(slot.Requirements.alignment, reqs.alignment);
+        slot.Requirements.memoryTypeBits &= reqs.memoryTypeBits;
+        slot.Lifetimes.push_back({ resource.FirstUse, resource.LastUse });
+        resource.MemorySlot = slotIndex;
+    }
+
+    for (auto& slot : m_MemorySlots)
+    {
+        VK_CHK(m_Device.GetAllocator().Allocate(slot.Requirements, MemoryUsage::GpuOnly, false, slot.Memory));
+    }
+
+    for (ResourceId r : transients)
+    {
+        Resource& resource = m_Resources[r];
+        Allocation const& memory = m_MemorySlots[resource.MemorySlot].Memory;
+        VK_CHK(vkBindImageMemory(m_Device, resource.Image, memory.Memory, memory.Offset));
+
+        VkImageViewCreateInfo viewCI =
+            vks::inits::imageViewCreateInfo(resource.Image, VK_IMAGE_VIEW_TYPE_2D, resource.CreateInfo.format);
+        viewCI.subresourceRange = { resource.Aspect, 0, 1, 0, 1 };
+        VK_CHK(vkCreateImageView(m_Device, &viewCI, nullptr, &resource.View));
+    }
+
+    /* FirstUse and LastUse are compared against pass ids while computing barriers */
+    for (auto& resource : m_Resources)
+    {
+        if (UINT32_MAX != resource.FirstUse)
+        {
+            resource.FirstUse = m_Order[resource.FirstUse];
+            resource.LastUse = m_Order[resource.LastUse];
+        }
+    }
+}
+
+void RenderGraph::DestroyTransients(void) noexcept
+{
+    for (auto& resource : m_Resources)
+    {
+        if (resource.Imported)
+        {
+            continue;
+        }
+        if (resource.View)
+        {
+            vkDestroyImageView(m_Device, resource.View, nullptr);
+            resource.View = VK_NULL_HANDLE;
+        }
+        if (resource.Image)
+        {
+            vkDestroyImage(m_Device, resource.Image, nullptr);
+            resource.Image = VK_NULL_HANDLE;
+        }
+    }
+    for (auto& slot : m_MemorySlots)
+    {
+        m_Device.GetAllocator().Free(slot.Memory);
+    }
+    m_MemorySlots.clear();
+}
+
+/**
+* Cull, sort, create transient images and compute barriers, call again after changing the graph
+* The device must be idle or no longer using the transient images of a previous Compile
+*/
+void RenderGraph::Compile(void) noexcept
+{
+    DestroyTransients();
+
+    std::vector<bool> kept;
+    Cull(kept);
+    Sort(kept);
+    CreateTransients();
+    ComputeBarriers();
+
+    spdlog::debug("Render graph compiled: {} of {} passes, {} transient memory slots",
+        m_Order.size(), m_Passes.size(), m_MemorySlots.size());
+}
+
+void RenderGraph::EmitBarriers(VkCommandBuffer cmdBuffer, BarrierBatch const& batch) const noexcept
+{
+    if (0 == batch.SrcStages)
+    {
+        return;
+    }
+
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    for (auto const& barrier : batch.Barriers)
+    {
+        Resource const& resource = m_Resources[barrier.Resource];
+        if (resource.IsImage)
+        {
+            VkImageMemoryBarrier imageBarrier = vks::inits::imageMemoryBarrier();
+            imageBarrier.srcAccessMask = barrier.SrcAccess;
+            imageBarrier.dstAccessMask = barrier.DstAccess;
+            imageBarrier.oldLayout = barrier.OldLayout;
+            imageBarrier.newLayout = barrier.NewLayout;
+            imageBarrier.image = resource.Image;
+            imageBarrier.subresourceRange = { resource.Aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+            imageBarriers.push_back(imageBarrier);
+        }
+        else
+        {
+            VkBufferMemoryBarrier bufferBarrier = vks::inits::bufferMemoryBarrier();
+            bufferBarrier.srcAccessMask = barrier.SrcAccess;
+            bufferBarrier.dstAccessMask = barrier.DstAccess;
+            bufferBarrier.buffer = resource.Buffer;
+            bufferBarrier.offset = 0;
+            bufferBarrier.size = VK_WHOLE_SIZE;
+            bufferBarriers.push_back(bufferBarrier);
+        }
+    }
+
+    vkCmdPipelineBarrier(cmdBuffer, batch.SrcStages, batch.DstStages, 0,
+        0, nullptr,
+        (uint32_t)bufferBarriers.size(), bufferBarriers.data(),
+        (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
+
+/**
+* Record every compiled pass in order, each preceded by its merged barrier
+*/
+void RenderGraph::Execute(VkCommandBuffer cmdBuffer) const noexcept
+{
+    for (PassId p : m_Order)
+    {
+        Pass const& pass = m_Passes[p];
+        EmitBarriers(cmdBuffer, pass.Before);
+        pass.Execute(cmdBuffer, *this);
+    }
+    EmitBarriers(cmdBuffer, m_Final);
+}
+
+VkImage RenderGraph::GetImage(ResourceId id) const noexcept
+{
+    return m_Resources[id].Image;
+}
+
+VkImageView RenderGraph::GetView(ResourceId id) const noexcept
+{
+    return m_Resources[id].View;
+}
+
+VkBuffer RenderGraph::GetBuffer(ResourceId id) const noexcept
+{
+    return m_Resources[id].Buffer;
+}
+
+std::vector<RenderGraph::PassId> const& RenderGraph::GetOrder(void) const noexcept
+{
+    return m_Order;
+}
+}
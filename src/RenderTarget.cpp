@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <array>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/RenderTarget.hpp"
+
+namespace vks
+{
+/**
+* @param width, height requested extent
+* @param colorFormat format of the ring images
+* @param imageCount images in the ring, at least maxFramesInFlight so an acquired image is never in use
+* @param maxFramesInFlight frames recorded ahead of the GPU
+*/
+RenderTarget::RenderTarget(
+    Device const& device,
+    uint32_t& width,
+    uint32_t& height,
+    VkFormat colorFormat,
+    uint32_t imageCount,
+    uint32_t maxFramesInFlight
+) noexcept
+    : m_Device(device), m_QueueIndex(device.QueueIndex.Graphics), m_ColorFormat(colorFormat), m_Extent{ 0, 0 },
+    m_ImageIndex(0), m_CurrentFrame(0), m_MaxFramesInFlight(std::max(maxFramesInFlight, 1u)), m_PresentCount(0),
+    m_pDepthStencil(nullptr)
+{
+    m_ColorAttachments.resize(std::max(imageCount, m_MaxFramesInFlight), nullptr);
+    VkFormat depthFormat = device.SupportedDepthStencilFormat().value();
+
+    std::array<VkAttachmentDescription, 2> attachments = {};
+    attachments[0].format = m_ColorFormat;
+    attachments[0].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[0].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[0].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachments[0].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachments[0].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[0].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    /* no presentation engine, leave the image ready to be copied out */
+    attachments[0].finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+    attachments[1].format = depthFormat;
+    attachments[1].samples = VK_SAMPLE_COUNT_1_BIT;
+    attachments[1].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachments[1].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachments[1].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachments[1].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+    VkAttachmentReference colorReference = { 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkAttachmentReference depthReference = { 1, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL };
+
+    VkSubpassDescription subpassDescription = {};
+    subpassDescription.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpassDescription.colorAttachmentCount = 1;
+    subpassDescription.pColorAttachments = &colorReference;
+    subpassDescription.pDepthStencilAttachment = &depthReference;
+
+    std::array<VkSubpassDependency, 3> dependencies;
+
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+    dependencies[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT;
+    dependencies[0].dependencyFlags = 0;
+
+    /* a previous frame may still be copying the image out */
+    dependencies[1].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].dstSubpass = 0;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].srcAccessMask = 0;
+    dependencies[1].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_READ_BIT;
+    dependencies[1].dependencyFlags = 0;
+
+    dependencies[2].srcSubpass = 0;
+    dependencies[2].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[2].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[2].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    dependencies[2].dependencyFlags = 0;
+
+    VkRenderPassCreateInfo renderPassInfo = vks::inits::renderPassCreateInfo();
+    renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+    renderPassInfo.pAttachments = attachments.data();
+    renderPassInfo.subpassCount = 1;
+    renderPassInfo.pSubpasses = &subpassDescription;
+    renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+    renderPassInfo.pDependencies = dependencies.data();
+    VK_CHK(vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass));
+
+    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    cmdPoolInfo.queueFamilyIndex = m_QueueIndex;
+    VK_CHK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &m_CmdPool));
+
+    m_WaitFences.resize(m_MaxFramesInFlight);
+    VkFenceCreateInfo fenceCreateInfo = vks::inits::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+    for (auto& fence : m_WaitFences)
+    {
+        VK_CHK(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &fence));
+    }
+
+    m_CmdBuffers.resize(m_MaxFramesInFlight);
+    VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+        vks::inits::commandBufferAllocateInfo(m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, (uint32_t)m_CmdBuffers.size());
+    VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, m_CmdBuffers.data()));
+
+    Recreate(width, height);
+}
+
+RenderTarget::~RenderTarget(void) noexcept
+{
+    vkWaitForFences(m_Device, (uint32_t)m_WaitFences.size(), m_WaitFences.data(), VK_TRUE, UINT64_MAX);
+    Destroy();
+
+    for (auto fence : m_WaitFences)
+    {
+        vkDestroyFence(m_Device, fence, nullptr);
+    }
+    vkFreeCommandBuffers(m_Device, m_CmdPool, (uint32_t)m_CmdBuffers.size(), m_CmdBuffers.data());
+    vkDestroyCommandPool(m_Device, m_CmdPool, nullptr);
+    vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
+}
+
+void RenderTarget::Destroy(void) noexcept
+{
+    for (auto framebuffer : m_Framebuffers)
+    {
+        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+    }
+    m_Framebuffers.clear();
+    for (auto& pAttachment : m_ColorAttachments)
+    {
+        delete pAttachment;
+        pAttachment = nullptr;
+    }
+    m_Views.clear();
+    delete m_pDepthStencil;
+    m_pDepthStencil = nullptr;
+}
+
+/**
+* Recreate the images at a new extent
+* Unlike Swapchain this waits for the frames in flight, resizing an offscreen target is rare
+*
+* @param vsync ignored, there is no presentation engine to pace the frames
+*/
+void RenderTarget::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
+{
+    (void)vsync;
+    vkWaitForFences(m_Device, (uint32_t)m_WaitFences.size(), m_WaitFences.data(), VK_TRUE, UINT64_MAX);
+    Destroy();
+
+    m_Extent = { width, height };
+
+    VkImageCreateInfo colorCI =
+        vks::inits::imageCreateInfo(
+            (VkImageCreateFlags)0,
+            VK_IMAGE_TYPE_2D,
+            m_ColorFormat,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_SAMPLED_BIT
+            );
+    colorCI.extent = { width, height, 1 };
+    colorCI.mipLevels = 1;
+    colorCI.arrayLayers = 1;
+    VkImageViewCreateInfo colorViewCI =
+        vks::inits::imageViewCreateInfo(VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, m_ColorFormat);
+    colorViewCI.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+
+    for (auto& pAttachment : m_ColorAttachments)
+    {
+        pAttachment = new vks::FramebufferAttachment(m_Device, colorCI, colorViewCI);
+        m_Views.push_back(pAttachment->GetView());
+    }
+
+    VkFormat depthFormat = m_Device.SupportedDepthStencilFormat().value();
+    VkImageCreateInfo depthCI =
+        vks::inits::imageCreateInfo(
+            (VkImageCreateFlags)0,
+            VK_IMAGE_TYPE_2D,
+            depthFormat,
+            VK_SAMPLE_COUNT_1_BIT,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT
+            );
+    depthCI.extent = { width, height, 1 };
+    depthCI.mipLevels = 1;
+    depthCI.arrayLayers = 1;
+    VkImageViewCreateInfo depthViewCI =
+        vks::inits::imageViewCreateInfo(VK_NULL_HANDLE, VK_IMAGE_VIEW_TYPE_2D, depthFormat);
+    depthViewCI.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+    if (depthFormat >= VK_FORMAT_D16_UNORM_S8_UINT) {
+        depthViewCI.subresourceRange.aspectMask |= VK_IMAGE_ASPECT_STENCIL_BIT;
+    }
+    m_pDepthStencil = new vks::FramebufferAttachment(m_Device, depthCI, depthViewCI);
+
+    VkImageView attachments[2];
+    attachments[1] = m_pDepthStencil->GetView();
+    VkFramebufferCreateInfo framebufferInfo = vks::inits::framebufferCreateInfo();
+    framebufferInfo.renderPass = m_RenderPass;
+    framebufferInfo.attachmentCount = 2;
+    framebufferInfo.pAttachments = attachments;
+    framebufferInfo.width = width;
+    framebufferInfo.height = height;
+    framebufferInfo.layers = 1;
+
+    m_Framebuffers.resize(m_Views.size());
+    for (size_t i = 0; i < m_Views.size(); i++)
+    {
+        attachments[0] = m_Views[i];
+        VK_CHK(vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_Framebuffers[i]));
+    }
+}
+
+/**
+* Advance to the next frame slot and image, waiting only for the fence of that slot
+* The image was last rendered GetImageCount frames ago, at least as long ago as the frame of the slot
+*/
+VkResult RenderTarget::AcquireNextImage(void) noexcept
+{
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlight;
+    m_ImageIndex = (m_ImageIndex + 1) % (uint32_t)m_ColorAttachments.size();
+
+    vkWaitForFences(m_Device, 1, &m_WaitFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
+    vkResetFences(m_Device, 1, &m_WaitFences[m_CurrentFrame]);
+    return VK_SUCCESS;
+}
+
+/**
+* Submit the command buffer of the current frame
+*
+* @param extraWaitSemaphores semaphores to wait on, there is no image acquisition to wait for
+* @param extraWaitStages stage masks of the extra semaphores
+*/
+VkResult RenderTarget::QueueSubmit(
+    VkQueue queue,
+    std::vector<VkSemaphore> const& extraWaitSemaphores,
+    std::vector<VkPipelineStageFlags> const& extraWaitStages
+) const noexcept
+{
+    assert(extraWaitSemaphores.size() == extraWaitStages.size());
+    VkSubmitInfo submitInfo = vks::inits::submitInfo();
+    submitInfo.waitSemaphoreCount = (uint32_t)extraWaitSemaphores.size();
+    submitInfo.pWaitSemaphores = extraWaitSemaphores.data();
+    submitInfo.pWaitDstStageMask = extraWaitStages.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &m_CmdBuffers[m_CurrentFrame];
+    return vkQueueSubmit(queue, 1, &submitInfo, m_WaitFences[m_CurrentFrame]);
+}
+
+/**
+* Nothing is shown, the frame is only counted, the image stays readable until it comes around again
+*/
+VkResult RenderTarget::QueuePresent(VkQueue queue) noexcept
+{
+    (void)queue;
+    m_PresentCount++;
+    return VK_SUCCESS;
+}
+
+/**
+* Fence signaled by the submit of the current frame, reset by AcquireNextImage
+*/
+VkFence const& RenderTarget::GetFence(void) const noexcept
+{
+    return m_WaitFences[m_CurrentFrame];
+}
+
+VkRenderPass const& RenderTarget::GetRenderPass(void) const noexcept
+{
+    return m_RenderPass;
+}
+
+uint32_t const& RenderTarget::GetQueueIndex(void) const noexcept
+{
+    return m_QueueIndex;
+}
+
+uint32_t const& RenderTarget::GetCurrentFrame(void) const noexcept
+{
+    return m_CurrentFrame;
+}
+
+uint32_t const& RenderTarget::GetImageIndex(void) const noexcept
+{
+    return m_ImageIndex;
+}
+
+uint32_t RenderTarget::GetMaxFramesInFlight(void) const noexcept
+{
+    return m_MaxFramesInFlight;
+}
+
+size_t RenderTarget::GetImageCount(void) const noexcept
+{
+    return m_ColorAttachments.size();
+}
+
+VkFormat const& RenderTarget::GetColorFormat(void) const noexcept
+{
+    return m_ColorFormat;
+}
+
+VkExtent2D const& RenderTarget::GetExtent(void) const noexcept
+{
+    return m_Extent;
+}
+
+std::vector<VkImageView> const& RenderTarget::GetImageViews(void) const noexcept
+{
+    return m_Views;
+}
+
+VkImage const& RenderTarget::GetImage(uint32_t imageIndex) const noexcept
+{
+    return m_ColorAttachments[imageIndex]->GetImage();
+}
+
+/**
+* Frames presented since construction, for throughput measurements
+*/
+uint64_t RenderTarget::GetPresentCount(void) const noexcept
+{
+    return m_PresentCount;
+}
+
+VkCommandBuffer const& RenderTarget::GetCommandBuffer(void) const noexcept
+{
+    return m_CmdBuffers[m_CurrentFrame];
+}
+
+VkFramebuffer const& RenderTarget::GetFramebuffer(void) const noexcept
+{
+    return m_Framebuffers[m_ImageIndex];
+}
+}
@@ -0,0 +1,278 @@
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/ResourceTracker.hpp"
+
+namespace vks
+{
+/* device level, loaded by the first ResourceTracker since the application targets Vulkan 1.0 */
+static PFN_vkCmdPipelineBarrier2KHR vkCmdPipelineBarrier2KHR = nullptr;
+
+static constexpr VkAccessFlags2KHR WRITE_ACCESS =
+    VK_ACCESS_2_SHADER_WRITE_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT | VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT |
+    VK_ACCESS_2_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_2_TRANSFER_WRITE_BIT | VK_ACCESS_2_HOST_WRITE_BIT |
+    VK_ACCESS_2_MEMORY_WRITE_BIT;
+
+ResourceTracker::ResourceTracker(Device const& device) noexcept
+    : m_Device(device), m_CmdBuffer(VK_NULL_HANDLE), m_Batch(0)
+{
+    vkCmdPipelineBarrier2KHR =
+        reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(vkGetDeviceProcAddr(device, "vkCmdPipelineBarrier2KHR"));
+    if (!vkCmdPipelineBarrier2KHR)
+    {
+        vks::utils::exitFatal("VK_KHR_synchronization2 is not enabled on the device", -1);
+    }
+}
+
+bool ResourceTracker::IsPending(State const& state) const noexcept
+{
+    return state.PendingBatch == m_Batch;
+}
+
+/**
+* Move a resource to its next use
+*
+* @param transition the use changes the image layout, which counts as a write
+* @param srcStages stages the barrier has to wait for, when one is needed
+* @param srcAccess accesses the barrier has to make available, when one is needed
+*
+* @return true if a barrier is needed before the use
+*/
+bool ResourceTracker::Use(
+    State& state,
+    VkPipelineStageFlags2KHR stages,
+    VkAccessFlags2KHR access,
+    bool transition,
+    VkPipelineStageFlags2KHR& srcStages,
+    VkAccessFlags2KHR& srcAccess
+) noexcept
+{
+    bool write = 0 != (access & WRITE_ACCESS);
+    if (write || transition)
+    {
+        /* writes only wait for earlier reads, nothing they did has to be made available */
+        srcStages = state.WriteStages | state.ReadStages;
+        srcAccess = state.WriteAccess;
+        bool needed = transition || (0 != srcStages);
+
+        state.WriteStages = stages;
+        state.WriteAccess = access & WRITE_ACCESS;
+        /* a transition before a read is visible to that read, a new write is visible to nothing yet */
+        state.VisibleStages = write ? 0 : stages;
+        state.VisibleAccess = write ? 0 : access;
+        state.ReadStages = write ? 0 : stages;
+        return needed;
+    }
+
+    state.ReadStages |= stages;
+    if ((0 == state.WriteStages) ||
+        ((0 == (stages & ~state.VisibleStages)) && (0 == (access & ~state.VisibleAccess))))
+    {
+        return false;
+    }
+    srcStages = state.WriteStages;
+    srcAccess = state.WriteAccess;
+    state.VisibleStages |= stages;
+    state.VisibleAccess |= access;
+    return true;
+}
+
+/**
+* Start recording barriers into a command buffer, tracked state is kept from the previous one
+*/
+void ResourceTracker::Begin(VkCommandBuffer cmdBuffer) noexcept
+{
+    assert(m_MemoryBarriers.empty() && m_ImageBarriers.empty());
+    m_CmdBuffer = cmdBuffer;
+}
+
+/**
+* Flush the queued barriers, call before vkEndCommandBuffer
+*/
+void ResourceTracker::End(void) noexcept
+{
+    Flush();
+    m_CmdBuffer = VK_NULL_HANDLE;
+}
+
+/**
+* Forget every resource, e.g. after vkDeviceWaitIdle
+*/
+void ResourceTracker::Reset(void) noexcept
+{
+    assert(m_MemoryBarriers.empty() && m_ImageBarriers.empty());
+    m_Buffers.clear();
+    m_Images.clear();
+}
+
+/**
+* Tell the tracker how an image was left outside of it, e.g. a swapchain image or an attachment of a
+* render pass with a final layout. Images used without this start in VK_IMAGE_LAYOUT_UNDEFINED with the
+* color aspect, so depth and stencil images have to be declared here first.
+*
+* @param stages stages that last accessed the image, NONE if an earlier submit or semaphore covers them
+* @param access writes that still have to be made available
+*/
+void ResourceTracker::SetImageState(
+    VkImage image,
+    VkImageAspectFlags aspect,
+    VkImageLayout layout,
+    VkPipelineStageFlags2KHR stages,
+    VkAccessFlags2KHR access
+) noexcept
+{
+    ImageState& state = m_Images[image];
+    assert(!IsPending(state));
+    state = ImageState{};
+    state.Aspect = aspect;
+    state.Layout = layout;
+    state.WriteStages = stages;
+    state.WriteAccess = access & WRITE_ACCESS;
+}
+
+void ResourceTracker::Forget(VkImage image) noexcept
+{
+    m_Images.erase(image);
+}
+
+void ResourceTracker::Forget(VkBuffer buffer) noexcept
+{
+    m_Buffers.erase(buffer);
+}
+
+/**
+* Declare the next use of a whole buffer, the barrier it needs is recorded by the next Flush
+*/
+void ResourceTracker::UseBuffer(VkBuffer buffer, VkPipelineStageFlags2KHR stages, VkAccessFlags2KHR access) noexcept
+{
+    State& state = m_Buffers[buffer];
+    if (IsPending(state))
+    {
+        if (!state.PendingWrite && (0 == (access & WRITE_ACCESS)))
+        {
+            /* a second read before the flush rides on the queued barrier of a read */
+            VkMemoryBarrier2KHR& barrier = m_MemoryBarriers[state.PendingIndex];
+            barrier.dstStageMask |= stages;
+            barrier.dstAccessMask |= access;
+            state.VisibleStages |= stages;
+            state.VisibleAccess |= access;
+            state.ReadStages |= stages;
+            return;
+        }
+        Flush();
+    }
+
+    VkPipelineStageFlags2KHR srcStages;
+    VkAccessFlags2KHR srcAccess;
+    if (!Use(state, stages, access, false, srcStages, srcAccess))
+    {
+        return;
+    }
+
+    /* buffers need no layout or range, hazards with the same stages share one global barrier */
+    state.PendingBatch = m_Batch;
+    state.PendingWrite = 0 != (access & WRITE_ACCESS);
+    for (size_t i = 0; i < m_MemoryBarriers.size(); i++)
+    {
+        VkMemoryBarrier2KHR& barrier = m_MemoryBarriers[i];
+        if ((barrier.srcStageMask == srcStages) && (barrier.dstStageMask == stages))
+        {
+            barrier.srcAccessMask |= srcAccess;
+            barrier.dstAccessMask |= access;
+            state.PendingIndex = i;
+            return;
+        }
+    }
+
+    VkMemoryBarrier2KHR barrier = vks::inits::memoryBarrier2();
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstStageMask = stages;
+    barrier.dstAccessMask = access;
+    state.PendingIndex = m_MemoryBarriers.size();
+    m_MemoryBarriers.push_back(barrier);
+}
+
+/**
+* Declare the next use of every subresource of an image, the barrier it needs is recorded by the next Flush
+*/
+void ResourceTracker::UseImage(
+    VkImage image,
+    VkPipelineStageFlags2KHR stages,
+    VkAccessFlags2KHR access,
+    VkImageLayout layout
+) noexcept
+{
+    ImageState& state = m_Images[image];
+    if (IsPending(state))
+    {
+        if (!state.PendingWrite && (layout == state.Layout) && (0 == (access & WRITE_ACCESS)))
+        {
+            VkImageMemoryBarrier2KHR& barrier = m_ImageBarriers[state.PendingIndex];
+            barrier.dstStageMask |= stages;
+            barrier.dstAccessMask |= access;
+            state.VisibleStages |= stages;
+            state.VisibleAccess |= access;
+            state.ReadStages |= stages;
+            return;
+        }
+        Flush();
+    }
+
+    VkImageLayout oldLayout = state.Layout;
+    VkPipelineStageFlags2KHR srcStages;
+    VkAccessFlags2KHR srcAccess;
+    if (!Use(state, stages, access, layout != oldLayout, srcStages, srcAccess))
+    {
+        return;
+    }
+    state.Layout = layout;
+
+    VkImageMemoryBarrier2KHR barrier = vks::inits::imageMemoryBarrier2();
+    barrier.srcStageMask = srcStages;
+    barrier.srcAccessMask = srcAccess;
+    barrier.dstStageMask = stages;
+    barrier.dstAccessMask = access;
+    barrier.oldLayout = oldLayout;
+    barrier.newLayout = layout;
+    barrier.image = image;
+    barrier.subresourceRange = { state.Aspect, 0, VK_REMAINING_MIP_LEVELS, 0, VK_REMAINING_ARRAY_LAYERS };
+    state.PendingBatch = m_Batch;
+    state.PendingWrite = 0 != (access & WRITE_ACCESS);
+    state.PendingIndex = m_ImageBarriers.size();
+    m_ImageBarriers.push_back(barrier);
+}
+
+/**
+* Record every queued barrier with one vkCmdPipelineBarrier2KHR, call before the commands using the resources
+*/
+void ResourceTracker::Flush(void) noexcept
+{
+    if (m_MemoryBarriers.empty() && m_ImageBarriers.empty())
+    {
+        return;
+    }
+    assert(VK_NULL_HANDLE != m_CmdBuffer);
+
+    VkDependencyInfoKHR dependencyInfo = vks::inits::dependencyInfo();
+    dependencyInfo.memoryBarrierCount = (uint32_t)m_MemoryBarriers.size();
+    dependencyInfo.pMemoryBarriers = m_MemoryBarriers.data();
+    dependencyInfo.imageMemoryBarrierCount = (uint32_t)m_ImageBarriers.size();
+    dependencyInfo.pImageMemoryBarriers = m_ImageBarriers.data();
+    vkCmdPipelineBarrier2KHR(m_CmdBuffer, &dependencyInfo);
+
+    m_MemoryBarriers.clear();
+    m_ImageBarriers.clear();
+    m_Batch++;
+}
+
+/**
+* Layout the image is in after the declared uses, VK_IMAGE_LAYOUT_UNDEFINED for unknown images
+*/
+VkImageLayout ResourceTracker::GetImageLayout(VkImage image) const noexcept
+{
+    auto it = m_Images.find(image);
+    return (m_Images.end() == it) ? VK_IMAGE_LAYOUT_UNDEFINED : it->second.Layout;
+}
+}
@@ -0,0 +1,304 @@
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/ShaderCache.hpp"
+
+namespace vks
+{
+/* device level, loaded by the first ShaderCache since the application targets Vulkan 1.0 */
+static PFN_vkGetShaderModuleCreateInfoIdentifierEXT vkGetShaderModuleCreateInfoIdentifierEXT = nullptr;
+
+static constexpr uint32_t SPIRV_MAGIC = 0x07230203;
+/* magic, version, generator, bound and schema words */
+static constexpr size_t SPIRV_HEADER_SIZE = 5 * sizeof(uint32_t);
+
+/**
+* Map a whole file read-only
+*
+* @return start of the mapping, nullptr if the file could not be opened or is empty
+*/
+static void const* MapFile(std::string const& path, size_t& size) noexcept
+{
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (INVALID_HANDLE_VALUE == file)
+    {
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    void const* pData = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && (fileSize.QuadPart > 0))
+    {
+        /* the view keeps the mapping alive once both handles are closed */
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (nullptr != mapping)
+        {
+            pData = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        size = (size_t)fileSize.QuadPart;
+    }
+    CloseHandle(file);
+    return pData;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return nullptr;
+    }
+    struct stat st;
+    void* pData = MAP_FAILED;
+    if ((0 == fstat(fd, &st)) && (st.st_size > 0))
+    {
+        size = (size_t)st.st_size;
+        pData = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);
+    return (MAP_FAILED == pData) ? nullptr : pData;
+#endif
+}
+
+static void UnmapFile(void const* pData, size_t size) noexcept
+{
+#if defined(_WIN32)
+    (void)size;
+    UnmapViewOfFile(pData);
+#else
+    munmap(const_cast<void*>(pData), size);
+#endif
+}
+
+/* 64-bit FNV-1a over the SPIR-V words */
+static uint64_t HashCode(uint32_t const* pCode, size_t wordCount) noexcept
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+    for (size_t i = 0; i < wordCount; i++)
+    {
+        hash = (hash ^ pCode[i]) * 0x100000001b3ull;
+    }
+    return hash;
+}
+
+uint64_t ShaderCache::Shader::GetHash(void) const noexcept
+{
+    return m_Hash;
+}
+
+bool ShaderCache::Shader::HasIdentifier(void) const noexcept
+{
+    return 0 != m_Identifier.identifierSize;
+}
+
+VkShaderModuleIdentifierEXT const& ShaderCache::Shader::GetIdentifier(void) const noexcept
+{
+    return m_Identifier;
+}
+
+/**
+* @param device logical device, enable VK_EXT_shader_module_identifier and its feature to skip module creation
+*/
+ShaderCache::ShaderCache(Device const& device) noexcept
+    : m_Device(device), m_IdentifierEnabled(false)
+{
+    vkGetShaderModuleCreateInfoIdentifierEXT = reinterpret_cast<PFN_vkGetShaderModuleCreateInfoIdentifierEXT>(
+        vkGetDeviceProcAddr(device, "vkGetShaderModuleCreateInfoIdentifierEXT"));
+    m_IdentifierEnabled = (nullptr != vkGetShaderModuleCreateInfoIdentifierEXT);
+}
+
+ShaderCache::~ShaderCache(void) noexcept
+{
+    for (auto& entry : m_Shaders)
+    {
+        if (0 != entry.second->m_RefCount)
+        {
+            spdlog::warn("Shader {:016x} still has {} references when the cache is destroyed", entry.first, entry.second->m_RefCount);
+        }
+        if (VK_NULL_HANDLE != entry.second->m_Module)
+        {
+            vkDestroyShaderModule(m_Device, entry.second->m_Module, nullptr);
+        }
+        Unmap(*entry.second);
+        delete entry.second;
+    }
+}
+
+VkShaderModuleCreateInfo ShaderCache::GetModuleCreateInfo(Shader const& shader) const noexcept
+{
+    VkShaderModuleCreateInfo moduleCreateInfo{};
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.codeSize = shader.m_CodeSize;
+    moduleCreateInfo.pCode = static_cast<uint32_t const*>(shader.m_pCode);
+    return moduleCreateInfo;
+}
+
+void ShaderCache::Unmap(Shader& shader) const noexcept
+{
+    if (nullptr != shader.m_pCode)
+    {
+        UnmapFile(shader.m_pCode, shader.m_CodeSize);
+        shader.m_pCode = nullptr;
+    }
+}
+
+/**
+* Load a SPIR-V file, or take another reference on the shader already loaded with the same path or code
+* A path is only mapped the first time it is loaded, a file changed on disk needs a new cache to be seen
+*
+* @return shader to be handed back to Release, nullptr if the file is missing or not valid SPIR-V
+*/
+ShaderCache::Shader const* ShaderCache::Load(std::string const& path) noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(m_Mutex);
+        auto it = m_Paths.find(path);
+        if (m_Paths.end() != it)
+        {
+            Shader* pShader = m_Shaders.at(it->second);
+            pShader->m_RefCount++;
+            return pShader;
+        }
+    }
+
+    /* mapped, checked and hashed without the lock so threads load files in parallel */
+    size_t size = 0;
+    void const* pData = MapFile(path, size);
+    if (nullptr == pData)
+    {
+        spdlog::error("Could not map shader file \"{}\"", path);
+        return nullptr;
+    }
+    uint32_t const* pCode = static_cast<uint32_t const*>(pData);
+    if ((size < SPIRV_HEADER_SIZE) || (0 != size % sizeof(uint32_t)) ||
+        (0 != reinterpret_cast<uintptr_t>(pData) % alignof(uint32_t)) || (SPIRV_MAGIC != pCode[0]))
+    {
+        spdlog::error("Shader file \"{}\" is not SPIR-V", path);
+        UnmapFile(pData, size);
+        return nullptr;
+    }
+    uint64_t hash = HashCode(pCode, size / sizeof(uint32_t));
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Paths[path] = hash;
+    auto it = m_Shaders.find(hash);
+    if (m_Shaders.end() != it)
+    {
+        UnmapFile(pData, size);
+        it->second->m_RefCount++;
+        return it->second;
+    }
+
+    Shader* pShader = new Shader;
+    pShader->m_Hash = hash;
+    pShader->m_RefCount = 1;
+    pShader->m_Module = VK_NULL_HANDLE;
+    pShader->m_Identifier = {};
+    pShader->m_Identifier.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_IDENTIFIER_EXT;
+    pShader->m_pCode = pData;
+    pShader->m_CodeSize = size;
+
+    VkShaderModuleCreateInfo moduleCreateInfo = GetModuleCreateInfo(*pShader);
+    if (m_IdentifierEnabled)
+    {
+        vkGetShaderModuleCreateInfoIdentifierEXT(m_Device, &moduleCreateInfo, &pShader->m_Identifier);
+    }
+    else
+    {
+        /* the driver copies the code, no need to keep the file mapped */
+        VK_CHK(vkCreateShaderModule(m_Device, &moduleCreateInfo, nullptr, &pShader->m_Module));
+        Unmap(*pShader);
+    }
+    m_Shaders[hash] = pShader;
+    return pShader;
+}
+
+/**
+* Drop a reference taken by Load, the module is destroyed with the last one
+* Pipelines created from the shader stay valid
+*/
+void ShaderCache::Release(Shader const* pShader) noexcept
+{
+    if (nullptr == pShader)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Shader* pEntry = m_Shaders.at(pShader->m_Hash);
+    assert(pEntry->m_RefCount > 0);
+    if (0 != --pEntry->m_RefCount)
+    {
+        return;
+    }
+
+    if (VK_NULL_HANDLE != pEntry->m_Module)
+    {
+        vkDestroyShaderModule(m_Device, pEntry->m_Module, nullptr);
+    }
+    Unmap(*pEntry);
+    m_Shaders.erase(pEntry->m_Hash);
+    std::erase_if(m_Paths, [pEntry](auto const& path) { return path.second == pEntry->m_Hash; });
+    delete pEntry;
+}
+
+/**
+* Get the module of a shader, creating it from the mapped file if only its identifier was taken, e.g. after
+* a pipeline created from the identifier returned VK_PIPELINE_COMPILE_REQUIRED
+*/
+VkShaderModule ShaderCache::GetModule(Shader const* pShader) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Shader* pEntry = m_Shaders.at(pShader->m_Hash);
+    if (VK_NULL_HANDLE == pEntry->m_Module)
+    {
+        VkShaderModuleCreateInfo moduleCreateInfo = GetModuleCreateInfo(*pEntry);
+        VK_CHK(vkCreateShaderModule(m_Device, &moduleCreateInfo, nullptr, &pEntry->m_Module));
+        Unmap(*pEntry);
+    }
+    return pEntry->m_Module;
+}
+
+/**
+* Point a pipeline stage at a shader, by identifier when there is one, in which case the pipeline has to be
+* created with VK_PIPELINE_CREATE_FAIL_ON_PIPELINE_COMPILE_REQUIRED_BIT and, if that fails, again after
+* filling the stage from GetModule
+*
+* @param identifierInfo chained into the stage when the identifier is used, must live as long as the stage
+*/
+void ShaderCache::FillStage(
+    Shader const* pShader,
+    VkPipelineShaderStageCreateInfo& stage,
+    VkPipelineShaderStageModuleIdentifierCreateInfoEXT& identifierInfo
+) noexcept
+{
+    if (pShader->HasIdentifier())
+    {
+        identifierInfo = {};
+        identifierInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_MODULE_IDENTIFIER_CREATE_INFO_EXT;
+        identifierInfo.identifierSize = pShader->m_Identifier.identifierSize;
+        identifierInfo.pIdentifier = pShader->m_Identifier.identifier;
+        identifierInfo.pNext = stage.pNext;
+        stage.pNext = &identifierInfo;
+        stage.module = VK_NULL_HANDLE;
+    }
+    else
+    {
+        stage.module = GetModule(pShader);
+    }
+}
+
+bool ShaderCache::IsIdentifierEnabled(void) const noexcept
+{
+    return m_IdentifierEnabled;
+}
+}
@@ -0,0 +1,637 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/ShaderReflection.hpp"
+
+namespace vks
+{
+/* the subset of the SPIR-V grammar reflection needs */
+namespace spv
+{
+static constexpr uint32_t MAGIC = 0x07230203;
+static constexpr size_t HEADER_WORDS = 5;
+
+enum Op : uint32_t
+{
+    OpEntryPoint = 15,
+    OpTypeBool = 20,
+    OpTypeInt = 21,
+    OpTypeFloat = 22,
+    OpTypeVector = 23,
+    OpTypeMatrix = 24,
+    OpTypeImage = 25,
+    OpTypeSampler = 26,
+    OpTypeSampledImage = 27,
+    OpTypeArray = 28,
+    OpTypeRuntimeArray = 29,
+    OpTypeStruct = 30,
+    OpTypePointer = 32,
+    OpConstant = 43,
+    OpSpecConstant = 50,
+    OpSpecConstantOp = 52,
+    OpVariable = 59,
+    OpDecorate = 71,
+    OpMemberDecorate = 72,
+    OpTypeAccelerationStructureKHR = 5341,
+};
+
+enum Decoration : uint32_t
+{
+    DecorationSpecId = 1,
+    DecorationBlock = 2,
+    DecorationBufferBlock = 3,
+    DecorationArrayStride = 6,
+    DecorationMatrixStride = 7,
+    DecorationBuiltIn = 11,
+    DecorationLocation = 30,
+    DecorationBinding = 33,
+    DecorationDescriptorSet = 34,
+    DecorationOffset = 35,
+};
+
+enum StorageClass : uint32_t
+{
+    StorageClassUniformConstant = 0,
+    StorageClassInput = 1,
+    StorageClassUniform = 2,
+    StorageClassPushConstant = 9,
+    StorageClassStorageBuffer = 12,
+};
+
+enum Dim : uint32_t
+{
+    DimBuffer = 5,
+    DimSubpassData = 6,
+};
+}
+
+namespace
+{
+/* operands of the instruction declaring an id, after its result id */
+struct Declaration
+{
+    uint32_t Op = 0;
+    std::vector<uint32_t> Operands;
+};
+
+struct Module
+{
+    std::unordered_map<uint32_t, Declaration> Ids;
+    std::unordered_map<uint32_t, std::unordered_map<uint32_t, uint32_t>> Decorations;
+    /* (struct id << 32 | member) to decoration and value */
+    std::unordered_map<uint64_t, std::unordered_map<uint32_t, uint32_t>> MemberDecorations;
+    std::vector<uint32_t> Variables;
+
+    std::optional<uint32_t> GetDecoration(uint32_t id, uint32_t decoration) const noexcept
+    {
+        auto it = Decorations.find(id);
+        if ((Decorations.end() == it) || (0 == it->second.count(decoration)))
+        {
+            return std::nullopt;
+        }
+        return it->second.at(decoration);
+    }
+
+    std::optional<uint32_t> GetMemberDecoration(uint32_t id, uint32_t member, uint32_t decoration) const noexcept
+    {
+        auto it = MemberDecorations.find((uint64_t)id << 32 | member);
+        if ((MemberDecorations.end() == it) || (0 == it->second.count(decoration)))
+        {
+            return std::nullopt;
+        }
+        return it->second.at(decoration);
+    }
+
+    Declaration const& Get(uint32_t id) const noexcept
+    {
+        static Declaration const none;
+        auto it = Ids.find(id);
+        return (Ids.end() == it) ? none : it->second;
+    }
+
+    /**
+    * Length of an array type, a specialization constant length is its default value as the layout cannot
+    * know the specialized one, lengths computed by OpSpecConstantOp are taken as one
+    */
+    uint32_t GetArrayLength(uint32_t arrayId) const noexcept
+    {
+        Declaration const& length = Get(Get(arrayId).Operands[1]);
+        if ((spv::OpConstant == length.Op) && (length.Operands.size() >= 2))
+        {
+            return length.Operands[1];
+        }
+        if ((spv::OpSpecConstant == length.Op) && (length.Operands.size() >= 2))
+        {
+            spdlog::warn("Array length is specialization constant {}, reflected with its default value {}",
+                GetDecoration(Get(arrayId).Operands[1], spv::DecorationSpecId).value_or(UINT32_MAX), length.Operands[1]);
+            return length.Operands[1];
+        }
+        spdlog::warn("Array length is not a constant, reflected as one element");
+        return 1;
+    }
+
+    /* size of a type in a block, following the offsets and strides the compiler decorated it with */
+    uint32_t GetSize(uint32_t typeId, uint32_t matrixStride = 0) const noexcept
+    {
+        Declaration const& type = Get(typeId);
+        switch (type.Op)
+        {
+        case spv::OpTypeBool:
+            return 4;
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+            return type.Operands[0] / 8;
+        case spv::OpTypeVector:
+            return type.Operands[1] * GetSize(type.Operands[0]);
+        case spv::OpTypeMatrix:
+            return type.Operands[1] * (matrixStride ? matrixStride : GetSize(type.Operands[0]));
+        case spv::OpTypeArray:
+        {
+            uint32_t length = GetArrayLength(typeId);
+            uint32_t stride = GetDecoration(typeId, spv::DecorationArrayStride).value_or(GetSize(type.Operands[0]));
+            return length * stride;
+        }
+        case spv::OpTypeStruct:
+        {
+            uint32_t size = 0;
+            for (uint32_t i = 0; i < type.Operands.size(); i++)
+            {
+                uint32_t offset = GetMemberDecoration(typeId, i, spv::DecorationOffset).value_or(0);
+                uint32_t stride = GetMemberDecoration(typeId, i, spv::DecorationMatrixStride).value_or(0);
+                size = std::max(size, offset + GetSize(type.Operands[i], stride));
+            }
+            return size;
+        }
+        case spv::OpTypePointer:
+            /* physical storage buffer addresses */
+            return 8;
+        default:
+            return 0;
+        }
+    }
+};
+
+/* an entry point name is a nul terminated string packed into words */
+std::string ReadString(uint32_t const* pWords, size_t wordCount, size_t& consumed) noexcept
+{
+    std::string str;
+    for (consumed = 0; consumed < wordCount; consumed++)
+    {
+        for (uint32_t byte = 0; byte < 4; byte++)
+        {
+            char c = (char)((pWords[consumed] >> (8 * byte)) & 0xff);
+            if ('\0' == c)
+            {
+                consumed++;
+                return str;
+            }
+            str.push_back(c);
+        }
+    }
+    return str;
+}
+
+std::optional<VkShaderStageFlagBits> GetStage(uint32_t executionModel) noexcept
+{
+    switch (executionModel)
+    {
+    case 0:
+        return VK_SHADER_STAGE_VERTEX_BIT;
+    case 1:
+        return VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT;
+    case 2:
+        return VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT;
+    case 3:
+        return VK_SHADER_STAGE_GEOMETRY_BIT;
+    case 4:
+        return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case 5:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
+    default:
+        return std::nullopt;
+    }
+}
+
+std::optional<VkDescriptorType> GetDescriptorType(Module const& module, uint32_t typeId, uint32_t storageClass) noexcept
+{
+    Declaration const& type = module.Get(typeId);
+    switch (storageClass)
+    {
+    case spv::StorageClassUniform:
+        return module.GetDecoration(typeId, spv::DecorationBufferBlock) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    case spv::StorageClassStorageBuffer:
+        return VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+    case spv::StorageClassUniformConstant:
+        break;
+    default:
+        return std::nullopt;
+    }
+
+    switch (type.Op)
+    {
+    case spv::OpTypeSampler:
+        return VK_DESCRIPTOR_TYPE_SAMPLER;
+    case spv::OpTypeSampledImage:
+        return VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    case spv::OpTypeAccelerationStructureKHR:
+        return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
+    case spv::OpTypeImage:
+    {
+        /* sampled type, dim, depth, arrayed, multisampled, sampled, format */
+        uint32_t dim = type.Operands[1];
+        uint32_t sampled = type.Operands[5];
+        if (spv::DimSubpassData == dim)
+        {
+            return VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        }
+        if (spv::DimBuffer == dim)
+        {
+            return (2 == sampled) ? VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER;
+        }
+        return (2 == sampled) ? VK_DESCRIPTOR_TYPE_STORAGE_IMAGE : VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
+    }
+    default:
+        return std::nullopt;
+    }
+}
+
+VkFormat GetVertexFormat(Module const& module, uint32_t typeId) noexcept
+{
+    Declaration const& type = module.Get(typeId);
+    uint32_t components = 1;
+    Declaration const* pScalar = &type;
+    if (spv::OpTypeVector == type.Op)
+    {
+        components = type.Operands[1];
+        pScalar = &module.Get(type.Operands[0]);
+    }
+
+    static constexpr VkFormat floats[] = { VK_FORMAT_R32_SFLOAT, VK_FORMAT_R32G32_SFLOAT, VK_FORMAT_R32G32B32_SFLOAT, VK_FORMAT_R32G32B32A32_SFLOAT };
+    static constexpr VkFormat sints[] = { VK_FORMAT_R32_SINT, VK_FORMAT_R32G32_SINT, VK_FORMAT_R32G32B32_SINT, VK_FORMAT_R32G32B32A32_SINT };
+    static constexpr VkFormat uints[] = { VK_FORMAT_R32_UINT, VK_FORMAT_R32G32_UINT, VK_FORMAT_R32G32B32_UINT, VK_FORMAT_R32G32B32A32_UINT };
+    static constexpr VkFormat doubles[] = { VK_FORMAT_R64_SFLOAT, VK_FORMAT_R64G64_SFLOAT, VK_FORMAT_R64G64B64_SFLOAT, VK_FORMAT_R64G64B64A64_SFLOAT };
+    if ((components < 1) || (components > 4) || pScalar->Operands.empty())
+    {
+        return VK_FORMAT_UNDEFINED;
+    }
+    uint32_t width = pScalar->Operands[0];
+    if ((spv::OpTypeFloat == pScalar->Op) && (32 == width))
+    {
+        return floats[components - 1];
+    }
+    if ((spv::OpTypeFloat == pScalar->Op) && (64 == width))
+    {
+        return doubles[components - 1];
+    }
+    if ((spv::OpTypeInt == pScalar->Op) && (32 == width))
+    {
+        return pScalar->Operands[1] ? sints[components - 1] : uints[components - 1];
+    }
+    return VK_FORMAT_UNDEFINED;
+}
+}
+
+VkVertexInputBindingDescription ShaderReflection::GetVertexBinding(void) const noexcept
+{
+    return { 0, VertexStride, VK_VERTEX_INPUT_RATE_VERTEX };
+}
+
+/**
+* Reflect the first entry point of a SPIR-V module
+*
+* @return the reflected resources, std::nullopt if the code is not valid SPIR-V or has no supported entry point
+*/
+std::optional<ShaderReflection> ShaderReflection::Reflect(std::vector<uint32_t> const& code) noexcept
+{
+    if ((code.size() < spv::HEADER_WORDS) || (spv::MAGIC != code[0]))
+    {
+        spdlog::error("Shader code to reflect is not SPIR-V");
+        return std::nullopt;
+    }
+
+    Module module;
+    std::optional<ShaderReflection> reflection;
+    for (size_t i = spv::HEADER_WORDS; i < code.size();)
+    {
+        uint32_t wordCount = code[i] >> 16;
+        uint32_t op = code[i] & 0xffff;
+        if ((0 == wordCount) || (i + wordCount > code.size()))
+        {
+            spdlog::error("Truncated SPIR-V instruction at word {}", i);
+            return std::nullopt;
+        }
+        uint32_t const* pOperands = &code[i + 1];
+        uint32_t operandCount = wordCount - 1;
+
+        switch (op)
+        {
+        case spv::OpEntryPoint:
+            if (!reflection && (operandCount >= 3))
+            {
+                std::optional<VkShaderStageFlagBits> stage = GetStage(pOperands[0]);
+                if (!stage)
+                {
+                    spdlog::error("SPIR-V execution model {} is not supported by reflection", pOperands[0]);
+                    return std::nullopt;
+                }
+                size_t consumed;
+                reflection = ShaderReflection{};
+                reflection->Stage = *stage;
+                reflection->EntryPoint = ReadString(pOperands + 2, operandCount - 2, consumed);
+            }
+            break;
+        case spv::OpDecorate:
+            if (operandCount >= 2)
+            {
+                module.Decorations[pOperands[0]][pOperands[1]] = (operandCount >= 3) ? pOperands[2] : 0;
+            }
+            break;
+        case spv::OpMemberDecorate:
+            if (operandCount >= 3)
+            {
+                module.MemberDecorations[(uint64_t)pOperands[0] << 32 | pOperands[1]][pOperands[2]] = (operandCount >= 4) ? pOperands[3] : 0;
+            }
+            break;
+        case spv::OpTypeBool:
+        case spv::OpTypeInt:
+        case spv::OpTypeFloat:
+        case spv::OpTypeVector:
+        case spv::OpTypeMatrix:
+        case spv::OpTypeImage:
+        case spv::OpTypeSampler:
+        case spv::OpTypeSampledImage:
+        case spv::OpTypeArray:
+        case spv::OpTypeRuntimeArray:
+        case spv::OpTypeStruct:
+        case spv::OpTypePointer:
+        case spv::OpTypeAccelerationStructureKHR:
+            if (operandCount >= 1)
+            {
+                module.Ids[pOperands[0]] = { op, std::vector<uint32_t>(pOperands + 1, pOperands + operandCount) };
+            }
+            break;
+        case spv::OpConstant:
+        case spv::OpSpecConstant:
+        case spv::OpSpecConstantOp:
+        case spv::OpVariable:
+            /* result type first, then the result id */
+            if (operandCount >= 3)
+            {
+                module.Ids[pOperands[1]] = { op, { pOperands[0], pOperands[2] } };
+                if (spv::OpVariable == op)
+                {
+                    module.Variables.push_back(pOperands[1]);
+                }
+            }
+            break;
+        default:
+            break;
+        }
+        i += wordCount;
+    }
+
+    if (!reflection)
+    {
+        spdlog::error("SPIR-V module has no entry point");
+        return std::nullopt;
+    }
+    reflection->PushConstants = { reflection->Stage, 0, 0 };
+    reflection->VertexStride = 0;
+
+    for (uint32_t variable : module.Variables)
+    {
+        /* result type is a pointer to the variable's type */
+        Declaration const& decl = module.Get(variable);
+        uint32_t storageClass = decl.Operands[1];
+        Declaration const& pointer = module.Get(decl.Operands[0]);
+        if ((spv::OpTypePointer != pointer.Op) || (pointer.Operands.size() < 2))
+        {
+            continue;
+        }
+        uint32_t typeId = pointer.Operands[1];
+
+        if (spv::StorageClassPushConstant == storageClass)
+        {
+            Declaration const& block = module.Get(typeId);
+            uint32_t offset = UINT32_MAX;
+            for (uint32_t m = 0; m < block.Operands.size(); m++)
+            {
+                offset = std::min(offset, module.GetMemberDecoration(typeId, m, spv::DecorationOffset).value_or(0));
+            }
+            uint32_t size = module.GetSize(typeId);
+            if ((UINT32_MAX != offset) && (size > offset))
+            {
+                reflection->PushConstants = { reflection->Stage, offset, size - offset };
+            }
+            continue;
+        }
+
+        if ((spv::StorageClassInput == storageClass) && (VK_SHADER_STAGE_VERTEX_BIT == reflection->Stage))
+        {
+            std::optional<uint32_t> location = module.GetDecoration(variable, spv::DecorationLocation);
+            if (!location || module.GetDecoration(variable, spv::DecorationBuiltIn))
+            {
+                continue;
+            }
+            /* a matrix input takes one location per column */
+            Declaration const& type = module.Get(typeId);
+            uint32_t columns = (spv::OpTypeMatrix == type.Op) ? type.Operands[1] : 1;
+            uint32_t columnType = (spv::OpTypeMatrix == type.Op) ? type.Operands[0] : typeId;
+            for (uint32_t c = 0; c < columns; c++)
+            {
+                VkFormat format = GetVertexFormat(module, columnType);
+                if (VK_FORMAT_UNDEFINED == format)
+                {
+                    spdlog::warn("Vertex input at location {} has a type reflection does not map to a format", *location + c);
+                }
+                reflection->VertexAttributes.push_back({ *location + c, 0, format, module.GetSize(columnType) });
+            }
+            continue;
+        }
+
+        std::optional<uint32_t> set = module.GetDecoration(variable, spv::DecorationDescriptorSet);
+        std::optional<uint32_t> binding = module.GetDecoration(variable, spv::DecorationBinding);
+        if (!set || !binding)
+        {
+            continue;
+        }
+
+        uint32_t count = 1;
+        while ((spv::OpTypeArray == module.Get(typeId).Op) || (spv::OpTypeRuntimeArray == module.Get(typeId).Op))
+        {
+            Declaration const& array = module.Get(typeId);
+            if (spv::OpTypeArray == array.Op)
+            {
+                count *= module.GetArrayLength(typeId);
+            }
+            else
+            {
+                spdlog::warn("Unsized descriptor array at set {} binding {} is reflected as one descriptor", *set, *binding);
+            }
+            typeId = array.Operands[0];
+        }
+
+        std::optional<VkDescriptorType> descriptorType = GetDescriptorType(module, typeId, storageClass);
+        if (!descriptorType)
+        {
+            continue;
+        }
+        reflection->Bindings.push_back({ *set, vks::inits::descriptorSetLayoutBinding(*descriptorType, reflection->Stage, *binding, count) });
+    }
+
+    /* tightly packed in location order, the sizes were stashed in the offsets */
+    std::sort(reflection->VertexAttributes.begin(), reflection->VertexAttributes.end(),
+        [](auto const& a, auto const& b) { return a.location < b.location; });
+    for (auto& attribute : reflection->VertexAttributes)
+    {
+        uint32_t size = attribute.offset;
+        attribute.offset = reflection->VertexStride;
+        reflection->VertexStride += size;
+    }
+
+    return reflection;
+}
+
+PipelineLayoutCache::PipelineLayoutCache(Device const& device) noexcept
+    : m_Device(device)
+{
+}
+
+PipelineLayoutCache::~PipelineLayoutCache(void) noexcept
+{
+    for (auto& layout : m_Layouts)
+    {
+        vkDestroyPipelineLayout(m_Device, layout.second.PipelineLayout, nullptr);
+    }
+    for (auto& setLayout : m_SetLayouts)
+    {
+        vkDestroyDescriptorSetLayout(m_Device, setLayout.second, nullptr);
+    }
+}
+
+VkDescriptorSetLayout PipelineLayoutCache::GetSetLayoutLocked(std::vector<VkDescriptorSetLayoutBinding> bindings) noexcept
+{
+    std::sort(bindings.begin(), bindings.end(), [](auto const& a, auto const& b) { return a.binding < b.binding; });
+    std::vector<uint32_t> key;
+    for (auto const& binding : bindings)
+    {
+        key.insert(key.end(), { binding.binding, (uint32_t)binding.descriptorType, binding.descriptorCount, binding.stageFlags });
+    }
+
+    auto it = m_SetLayouts.find(key);
+    if (m_SetLayouts.end() != it)
+    {
+        return it->second;
+    }
+
+    VkDescriptorSetLayout setLayout;
+    VkDescriptorSetLayoutCreateInfo setLayoutCreateInfo = vks::inits::descriptorSetLayoutCreateInfo(bindings);
+    VK_CHK(vkCreateDescriptorSetLayout(m_Device, &setLayoutCreateInfo, nullptr, &setLayout));
+    m_SetLayouts.emplace(std::move(key), setLayout);
+    return setLayout;
+}
+
+/**
+* Get the descriptor set layout of a set of bindings, shared with every equal request
+* Immutable samplers are not part of the key and must not be set
+*/
+VkDescriptorSetLayout PipelineLayoutCache::GetSetLayout(std::vector<VkDescriptorSetLayoutBinding> bindings) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    return GetSetLayoutLocked(std::move(bindings));
+}
+
+/**
+* Get the layout of a pipeline made of the reflected stages
+*
+* @return the layout, owned by the cache and shared with every pipeline of the same interface
+*/
+PipelineLayoutCache::Layout const& PipelineLayoutCache::GetLayout(std::vector<ShaderReflection> const& stages) noexcept
+{
+    /* (set, binding) to the binding merged across stages */
+    std::map<std::pair<uint32_t, uint32_t>, VkDescriptorSetLayoutBinding> merged;
+    VkPushConstantRange pushConstants = { 0, UINT32_MAX, 0 };
+    for (auto const& stage : stages)
+    {
+        for (auto const& binding : stage.Bindings)
+        {
+            auto result = merged.insert({ { binding.Set, binding.Layout.binding }, binding.Layout });
+            VkDescriptorSetLayoutBinding& layout = result.first->second;
+            if (result.second)
+            {
+                continue;
+            }
+            if (layout.descriptorType != binding.Layout.descriptorType)
+            {
+                spdlog::warn("Stages disagree on the descriptor type of set {} binding {}", binding.Set, binding.Layout.binding);
+            }
+            layout.stageFlags |= binding.Layout.stageFlags;
+            layout.descriptorCount = std::max(layout.descriptorCount, binding.Layout.descriptorCount);
+        }
+
+        if (0 != stage.PushConstants.size)
+        {
+            uint32_t end = std::max(pushConstants.offset + pushConstants.size, stage.PushConstants.offset + stage.PushConstants.size);
+            if (UINT32_MAX == pushConstants.offset)
+            {
+                end = stage.PushConstants.offset + stage.PushConstants.size;
+            }
+            pushConstants.offset = std::min(pushConstants.offset, stage.PushConstants.offset);
+            pushConstants.size = end - pushConstants.offset;
+            pushConstants.stageFlags |= stage.PushConstants.stageFlags;
+        }
+    }
+    if (0 == pushConstants.size)
+    {
+        pushConstants = {};
+    }
+
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    Layout layout{};
+    layout.PushConstants = pushConstants;
+    if (!merged.empty())
+    {
+        layout.SetLayouts.resize(merged.rbegin()->first.first + 1);
+        for (uint32_t set = 0; set < layout.SetLayouts.size(); set++)
+        {
+            std::vector<VkDescriptorSetLayoutBinding> bindings;
+            for (auto it = merged.lower_bound({ set, 0 }); (merged.end() != it) && (it->first.first == set); it++)
+            {
+                bindings.push_back(it->second);
+            }
+            layout.SetLayouts[set] = GetSetLayoutLocked(std::move(bindings));
+        }
+    }
+
+    std::vector<uint64_t> key;
+    for (auto setLayout : layout.SetLayouts)
+    {
+        uint64_t handle = 0;
+        std::memcpy(&handle, &setLayout, sizeof(setLayout));
+        key.push_back(handle);
+    }
+    key.insert(key.end(), { pushConstants.stageFlags, pushConstants.offset, pushConstants.size });
+
+    auto it = m_Layouts.find(key);
+    if (m_Layouts.end() != it)
+    {
+        return it->second;
+    }
+
+    VkPipelineLayoutCreateInfo pipelineLayoutCreateInfo =
+        vks::inits::pipelineLayoutCreateInfo(layout.SetLayouts.data(), (uint32_t)layout.SetLayouts.size());
+    if (0 != pushConstants.size)
+    {
+        pipelineLayoutCreateInfo.pushConstantRangeCount = 1;
+        pipelineLayoutCreateInfo.pPushConstantRanges = &layout.PushConstants;
+    }
+    VK_CHK(vkCreatePipelineLayout(m_Device, &pipelineLayoutCreateInfo, nullptr, &layout.PipelineLayout));
+    return m_Layouts.emplace(std::move(key), std::move(layout)).first->second;
+}
+}
@@ -0,0 +1,496 @@
+#include <algorithm>
+
+#include "vks/Inits.hpp"
+#include "vks/Utils.hpp"
+#include "vks/Device.hpp"
+
+#include "vks/StagingUploader.hpp"
+
+namespace vks
+{
+/**
+* @param device logical device the uploads are recorded on
+* @param capacity size of the staging ring in bytes
+* @param transferQueue record and submit on the transfer queue, device must be created with VK_QUEUE_TRANSFER_BIT
+*/
+StagingUploader::StagingUploader(Device const& device, VkDeviceSize capacity, bool transferQueue) noexcept
+    : m_Device(device), m_Capacity(capacity), m_Head(0), m_Tail(0), m_LastSubmitted(0), m_LastCompleted(0)
+{
+    m_pRing = new Buffer(
+        device,
+        VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+        MemoryUsage::Upload,
+        capacity,
+        nullptr,
+        true
+    );
+
+    /* without a dedicated transfer family the uploads stay on the graphics queue and need no ownership transfer */
+    m_DstQueueFamily = device.QueueIndex.Graphics;
+    m_QueueFamily = transferQueue ? device.QueueIndex.Transfer : device.QueueIndex.Graphics;
+    m_OwnershipTransfer = m_QueueFamily != m_DstQueueFamily;
+    vkGetDeviceQueue(device, m_QueueFamily, 0, &m_Queue);
+
+    VkCommandPoolCreateInfo cmdPoolInfo =
+        vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    cmdPoolInfo.queueFamilyIndex = m_QueueFamily;
+    VK_CHK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &m_CmdPool));
+}
+
+StagingUploader::~StagingUploader(void) noexcept
+{
+    for (auto& batch : m_InFlight)
+    {
+        VK_CHK(vkWaitForFences(m_Device, 1, &batch.Fence, VK_TRUE, UINT64_MAX));
+        m_FreeCmdBuffers.push_back(batch.CmdBuffer);
+        m_FreeFences.push_back(batch.Fence);
+        if (batch.Semaphore)
+        {
+            m_FreeSemaphores.push_back(batch.Semaphore);
+        }
+    }
+    for (auto& batch : m_Released)
+    {
+        m_FreeSemaphores.push_back(batch.Semaphore);
+    }
+    /* the graphics submits waiting on acquired semaphores are not tracked beyond their fence, which may be reset */
+    if (!m_Acquired.empty())
+    {
+        VK_CHK(vkDeviceWaitIdle(m_Device));
+        for (auto& acquired : m_Acquired)
+        {
+            m_FreeSemaphores.push_back(acquired.Semaphore);
+        }
+    }
+
+    if (!m_BufferCopies.empty() || !m_ImageCopies.empty())
+    {
+        spdlog::warn("StagingUploader destroyed with {} copies never submitted", m_BufferCopies.size() + m_ImageCopies.size());
+    }
+
+    if (!m_FreeCmdBuffers.empty())
+    {
+        vkFreeCommandBuffers(m_Device, m_CmdPool, (uint32_t)m_FreeCmdBuffers.size(), m_FreeCmdBuffers.data());
+    }
+    for (auto fence : m_FreeFences)
+    {
+        vkDestroyFence(m_Device, fence, nullptr);
+    }
+    for (auto semaphore : m_FreeSemaphores)
+    {
+        vkDestroySemaphore(m_Device, semaphore, nullptr);
+    }
+    vkDestroyCommandPool(m_Device, m_CmdPool, nullptr);
+
+    delete m_pRing;
+}
+
+/**
+* Reserve a range of the ring, submitting queued copies and waiting on old batches while it is full
+*
+* @return offset of the range inside the ring buffer
+*/
+VkDeviceSize StagingUploader::Reserve(VkDeviceSize size, VkDeviceSize alignment) noexcept
+{
+    assert(size <= m_Capacity);
+
+    VkDeviceSize head;
+    VkDeviceSize offset;
+    while (true)
+    {
+        /* nothing in flight nor queued, restart at the beginning so a range never has to wrap */
+        if (m_InFlight.empty() && m_BufferCopies.empty() && m_ImageCopies.empty())
+        {
+            m_Head = 0;
+            m_Tail = 0;
+        }
+
+        head = (m_Head + alignment - 1) / alignment * alignment;
+        offset = head % m_Capacity;
+        /* ranges never wrap, skip the end of the ring instead */
+        if (offset + size > m_Capacity)
+        {
+            head += m_Capacity - offset;
+            offset = 0;
+        }
+
+        if (head + size - m_Tail <= m_Capacity)
+        {
+            break;
+        }
+
+        /* the range is recomputed once the ring drained, a skipped end may then fit from the start */
+        if (m_InFlight.empty())
+        {
+            SubmitLocked();
+        }
+        if (!m_InFlight.empty())
+        {
+            WaitOldest();
+        }
+    }
+
+    m_Head = head + size;
+    return offset;
+}
+
+/**
+* Copy data into the ring and queue a copy into a buffer, large uploads are split into several copies
+*
+* @param dst destination buffer, must be created with VK_BUFFER_USAGE_TRANSFER_DST_BIT
+* @param data source data, may be freed as soon as this returns
+* @param size number of bytes to copy
+* @param dstOffset byte offset into dst
+*/
+bool StagingUploader::Upload(Buffer const& dst, const void* data, VkDeviceSize size, VkDeviceSize dstOffset) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    const uint8_t* src = static_cast<const uint8_t*>(data);
+    VkDeviceSize chunkSize = m_Capacity / 4;
+    VkDeviceSize done = 0;
+    while (done < size)
+    {
+        VkDeviceSize chunk = std::min(chunkSize, size - done);
+        VkDeviceSize offset = Reserve(chunk, 16);
+        m_pRing->CopyData(src + done, (size_t)chunk, offset);
+
+        BufferCopy copy{};
+        copy.Dst = dst;
+        copy.Region.srcOffset = offset;
+        copy.Region.dstOffset = dstOffset + done;
+        copy.Region.size = chunk;
+        m_BufferCopies.push_back(copy);
+
+        done += chunk;
+    }
+    return true;
+}
+
+/**
+* Copy data into the ring and queue a copy into an image
+* The image is transitioned from UNDEFINED, so the copy must overwrite the whole subresource range
+*
+* @param dst destination image, must be created with VK_IMAGE_USAGE_TRANSFER_DST_BIT
+* @param range subresource range transitioned for the copy
+* @param region copy region, bufferOffset is filled by the uploader
+* @param data tightly packed texel data, unless region specifies a row length
+* @param size number of bytes to copy, must fit in the ring
+* @param finalLayout layout the image is left in once the copy is done
+*/
+bool StagingUploader::UploadImage(
+    VkImage dst,
+    VkImageSubresourceRange const& range,
+    VkBufferImageCopy region,
+    const void* data,
+    VkDeviceSize size,
+    VkImageLayout finalLayout
+) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+
+    if (size > m_Capacity)
+    {
+        spdlog::error("Image upload of {} bytes does not fit in a {} byte staging ring", size, m_Capacity);
+        return false;
+    }
+
+    VkDeviceSize alignment = std::max<VkDeviceSize>(16, m_Device.GetProperties().limits.optimalBufferCopyOffsetAlignment);
+    VkDeviceSize offset = Reserve(size, alignment);
+    m_pRing->CopyData(data, (size_t)size, offset);
+
+    region.bufferOffset = offset;
+    m_ImageCopies.push_back({ dst, range, region, finalLayout });
+    return true;
+}
+
+StagingUploader::Ticket StagingUploader::SubmitLocked(void) noexcept
+{
+    if (m_BufferCopies.empty() && m_ImageCopies.empty())
+    {
+        return m_LastSubmitted;
+    }
+
+    VK_CHK(m_pRing->FlushDirty());
+
+    Batch batch{};
+    if (!m_FreeCmdBuffers.empty())
+    {
+        batch.CmdBuffer = m_FreeCmdBuffers.back();
+        m_FreeCmdBuffers.pop_back();
+    }
+    else
+    {
+        VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+            vks::inits::commandBufferAllocateInfo(m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, 1);
+        VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, &batch.CmdBuffer));
+    }
+    if (!m_FreeFences.empty())
+    {
+        batch.Fence = m_FreeFences.back();
+        m_FreeFences.pop_back();
+        VK_CHK(vkResetFences(m_Device, 1, &batch.Fence));
+    }
+    else
+    {
+        VkFenceCreateInfo fenceInfo = vks::inits::fenceCreateInfo(VK_FLAGS_NONE);
+        VK_CHK(vkCreateFence(m_Device, &fenceInfo, nullptr, &batch.Fence));
+    }
+
+    VkCommandBufferBeginInfo cmdBufInfo = vks::inits::commandBufferBeginInfo();
+    cmdBufInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    VK_CHK(vkBeginCommandBuffer(batch.CmdBuffer, &cmdBufInfo));
+
+    /* one vkCmdCopyBuffer per destination, stable so overlapping writes keep their order */
+    std::stable_sort(m_BufferCopies.begin(), m_BufferCopies.end(),
+        [](BufferCopy const& a, BufferCopy const& b) { return a.Dst < b.Dst; });
+    std::vector<VkBufferCopy> regions;
+    for (size_t i = 0; i < m_BufferCopies.size();)
+    {
+        regions.clear();
+        size_t j = i;
+        for (; (j < m_BufferCopies.size()) && (m_BufferCopies[j].Dst == m_BufferCopies[i].Dst); j++)
+        {
+            regions.push_back(m_BufferCopies[j].Region);
+        }
+        vkCmdCopyBuffer(batch.CmdBuffer, *m_pRing, m_BufferCopies[i].Dst, (uint32_t)regions.size(), regions.data());
+        i = j;
+    }
+
+    if (!m_ImageCopies.empty())
+    {
+        std::vector<VkImageMemoryBarrier> barriers(m_ImageCopies.size(), vks::inits::imageMemoryBarrier());
+        for (size_t i = 0; i < m_ImageCopies.size(); i++)
+        {
+            barriers[i].image = m_ImageCopies[i].Dst;
+            barriers[i].subresourceRange = m_ImageCopies[i].Range;
+            barriers[i].srcAccessMask = 0;
+            barriers[i].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers[i].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+            barriers[i].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        }
+        vkCmdPipelineBarrier(batch.CmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0,
+            0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+        for (auto& copy : m_ImageCopies)
+        {
+            vkCmdCopyBufferToImage(batch.CmdBuffer, *m_pRing, copy.Dst, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy.Region);
+        }
+
+        for (size_t i = 0; i < m_ImageCopies.size(); i++)
+        {
+            barriers[i].srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barriers[i].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+            barriers[i].oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+            barriers[i].newLayout = m_ImageCopies[i].FinalLayout;
+        }
+        if (!m_OwnershipTransfer)
+        {
+            vkCmdPipelineBarrier(batch.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+        }
+        else
+        {
+            /* the release carries the layout transition, the acquire on the graphics queue repeats it */
+            for (auto& barrier : barriers)
+            {
+                barrier.dstAccessMask = 0;
+                barrier.srcQueueFamilyIndex = m_QueueFamily;
+                barrier.dstQueueFamilyIndex = m_DstQueueFamily;
+            }
+            batch.ImageBarriers = std::move(barriers);
+        }
+    }
+
+    if (m_OwnershipTransfer)
+    {
+        for (auto& copy : m_BufferCopies)
+        {
+            VkBufferMemoryBarrier barrier = vks::inits::bufferMemoryBarrier();
+            barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+            barrier.dstAccessMask = 0;
+            barrier.srcQueueFamilyIndex = m_QueueFamily;
+            barrier.dstQueueFamilyIndex = m_DstQueueFamily;
+            barrier.buffer = copy.Dst;
+            barrier.offset = copy.Region.dstOffset;
+            barrier.size = copy.Region.size;
+            batch.BufferBarriers.push_back(barrier);
+        }
+        vkCmdPipelineBarrier(batch.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr,
+            (uint32_t)batch.BufferBarriers.size(), batch.BufferBarriers.data(),
+            (uint32_t)batch.ImageBarriers.size(), batch.ImageBarriers.data());
+    }
+    /* make every buffer write visible to work submitted after this batch */
+    else if (!m_BufferCopies.empty())
+    {
+        VkMemoryBarrier memoryBarrier = vks::inits::memoryBarrier();
+        memoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        memoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        vkCmdPipelineBarrier(batch.CmdBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+            1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    VK_CHK(vkEndCommandBuffer(batch.CmdBuffer));
+
+    VkSubmitInfo submitInfo = vks::inits::submitInfo();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &batch.CmdBuffer;
+    if (m_OwnershipTransfer)
+    {
+        if (!m_FreeSemaphores.empty())
+        {
+            batch.Semaphore = m_FreeSemaphores.back();
+            m_FreeSemaphores.pop_back();
+        }
+        else
+        {
+            VkSemaphoreCreateInfo semaphoreInfo = vks::inits::semaphoreCreateInfo();
+            VK_CHK(vkCreateSemaphore(m_Device, &semaphoreInfo, nullptr, &batch.Semaphore));
+        }
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &batch.Semaphore;
+    }
+    VK_CHK(vkQueueSubmit(m_Queue, 1, &submitInfo, batch.Fence));
+
+    batch.Id = ++m_LastSubmitted;
+    batch.End = m_Head;
+    m_InFlight.push_back(std::move(batch));
+
+    m_BufferCopies.clear();
+    m_ImageCopies.clear();
+    return batch.Id;
+}
+
+/**
+* Release every batch whose fence has signaled, in submission order
+* Batches that transfer ownership keep their semaphore and barriers until RecordAcquire hands them over
+*/
+void StagingUploader::Retire(void) noexcept
+{
+    while (!m_InFlight.empty() && (VK_SUCCESS == vkGetFenceStatus(m_Device, m_InFlight.front().Fence)))
+    {
+        Batch& batch = m_InFlight.front();
+        m_Tail = batch.End;
+        m_LastCompleted = batch.Id;
+        m_FreeCmdBuffers.push_back(batch.CmdBuffer);
+        m_FreeFences.push_back(batch.Fence);
+        if (m_OwnershipTransfer)
+        {
+            m_Released.push_back(std::move(batch));
+        }
+        m_InFlight.pop_front();
+    }
+
+    /* a binary semaphore can be signaled again once the graphics submit waiting on it has finished */
+    auto done = std::remove_if(m_Acquired.begin(), m_Acquired.end(), [this](Acquired const& acquired) {
+        if (VK_SUCCESS != vkGetFenceStatus(m_Device, acquired.Fence))
+        {
+            return false;
+        }
+        m_FreeSemaphores.push_back(acquired.Semaphore);
+        return true;
+    });
+    m_Acquired.erase(done, m_Acquired.end());
+}
+
+void StagingUploader::WaitOldest(void) noexcept
+{
+    assert(!m_InFlight.empty());
+    VK_CHK(vkWaitForFences(m_Device, 1, &m_InFlight.front().Fence, VK_TRUE, UINT64_MAX));
+    Retire();
+}
+
+/**
+* Record every queued copy into one command buffer and submit it without waiting
+*
+* @return ticket of the submitted batch, or of the last batch if nothing was queued
+*/
+StagingUploader::Ticket StagingUploader::Submit(void) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Retire();
+    return SubmitLocked();
+}
+
+bool StagingUploader::IsComplete(Ticket ticket) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Retire();
+    return ticket <= m_LastCompleted;
+}
+
+/**
+* Block until the batch of a ticket has finished on the GPU
+*
+* @return VK_SUCCESS once complete, VK_TIMEOUT if the timeout expired first
+*/
+VkResult StagingUploader::Wait(Ticket ticket, uint64_t timeout) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Retire();
+    if (ticket <= m_LastCompleted)
+    {
+        return VK_SUCCESS;
+    }
+    assert(ticket <= m_LastSubmitted);
+
+    auto it = std::find_if(m_InFlight.begin(), m_InFlight.end(), [ticket](Batch const& b) { return b.Id == ticket; });
+    VkResult result = vkWaitForFences(m_Device, 1, &it->Fence, VK_TRUE, timeout);
+    Retire();
+    return result;
+}
+
+/**
+* Hand every completed upload to the graphics queue
+* Records the queue family acquire barriers into a graphics command buffer and returns the semaphores
+* the submit of that command buffer has to wait on. Only batches that already finished on the transfer
+* queue are acquired, so the waits never stall the graphics queue. Does nothing without ownership transfer.
+*
+* @param cmdBuffer graphics queue command buffer in the recording state, outside of a render pass
+* @param submitFence fence signaled by the submit of cmdBuffer, must be unsignaled until that submit
+* @param waitSemaphores semaphores are appended for the submit to wait on
+* @param waitStages stage masks are appended, one per semaphore
+*/
+void StagingUploader::RecordAcquire(
+    VkCommandBuffer cmdBuffer,
+    VkFence submitFence,
+    std::vector<VkSemaphore>& waitSemaphores,
+    std::vector<VkPipelineStageFlags>& waitStages
+) noexcept
+{
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    Retire();
+    if (m_Released.empty())
+    {
+        return;
+    }
+
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    for (auto& batch : m_Released)
+    {
+        for (auto barrier : batch.BufferBarriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            bufferBarriers.push_back(barrier);
+        }
+        for (auto barrier : batch.ImageBarriers)
+        {
+            barrier.srcAccessMask = 0;
+            barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+            imageBarriers.push_back(barrier);
+        }
+        waitSemaphores.push_back(batch.Semaphore);
+        waitStages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        m_Acquired.push_back({ batch.Semaphore, submitFence });
+    }
+    m_Released.clear();
+
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+        0, nullptr,
+        (uint32_t)bufferBarriers.size(), bufferBarriers.data(),
+        (uint32_t)imageBarriers.size(), imageBarriers.data());
+}
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <array>
 
 #include "vks/Inits.hpp"
@@ -6,15 +7,28 @@
 
 namespace vks
 {
+/* device level, loaded by a dynamic rendering Swapchain since the application targets Vulkan 1.0 */
+static PFN_vkCmdBeginRenderingKHR vkCmdBeginRenderingKHR = nullptr;
+static PFN_vkCmdEndRenderingKHR vkCmdEndRenderingKHR = nullptr;
+
+/**
+* @param maxFramesInFlight frames recorded ahead of the GPU, independent of the image count
+* @param dynamicRendering render with vkCmdBeginRenderingKHR instead of a render pass and framebuffers,
+* needs VK_KHR_dynamic_rendering enabled on the device
+*/
 Swapchain::Swapchain(
     Instance const& instance,
     Device const& device,
     VkSurfaceKHR surface,
     uint32_t& width,
     uint32_t& height,
-    bool vsync
+    bool vsync,
+    uint32_t maxFramesInFlight,
+    bool dynamicRendering
 )
-    : m_Instance(instance), m_Device(device), m_Surface(surface)
+    : m_Instance(instance), m_Device(device), m_Surface(surface), m_ImageIndex(0), m_CurrentFrame(0),
+    m_MaxFramesInFlight(std::max(maxFramesInFlight, 1u)), m_DynamicRendering(dynamicRendering),
+    m_RenderPass(VK_NULL_HANDLE), m_FrameNumber(0), m_CompletedFrame(0)
 {
     uint32_t queueCnt;
     vkGetPhysicalDeviceQueueFamilyProperties(device.GetPhysicalDevice(), &queueCnt, NULL);
@@ -100,6 +114,51 @@ Swapchain::Swapchain(
 
     m_pDepthStencil = new vks::FramebufferAttachment(device, imageCI, imageViewCI);
 
+    if (m_DynamicRendering)
+    {
+        vkCmdBeginRenderingKHR =
+            reinterpret_cast<PFN_vkCmdBeginRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdBeginRenderingKHR"));
+        vkCmdEndRenderingKHR =
+            reinterpret_cast<PFN_vkCmdEndRenderingKHR>(vkGetDeviceProcAddr(device, "vkCmdEndRenderingKHR"));
+        if (!vkCmdBeginRenderingKHR || !vkCmdEndRenderingKHR)
+        {
+            vks::utils::exitFatal("VK_KHR_dynamic_rendering is not enabled on the device", -1);
+        }
+    }
+    else
+    {
+        CreateRenderPass();
+    }
+
+    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
+    cmdPoolInfo.queueFamilyIndex = m_QueueIndex;
+    VK_CHK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &m_CmdPool));
+
+    /* frame resources do not depend on the swapchain, they live as long as it */
+    m_PresentDoneSemaphore.resize(m_MaxFramesInFlight);
+    m_WaitFences.resize(m_MaxFramesInFlight);
+    m_FenceFrames.assign(m_MaxFramesInFlight, 0);
+    VkSemaphoreCreateInfo semaphoreCreateInfo = vks::inits::semaphoreCreateInfo();
+    VkFenceCreateInfo fenceCreateInfo = vks::inits::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
+    for (uint32_t i = 0; i < m_MaxFramesInFlight; i++)
+    {
+        VK_CHK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_PresentDoneSemaphore[i]));
+        VK_CHK(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &m_WaitFences[i]));
+    }
+
+    m_CmdBuffers.resize(m_MaxFramesInFlight);
+    VkCommandBufferAllocateInfo cmdBufAllocateInfo =
+        vks::inits::commandBufferAllocateInfo(m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, (uint32_t)m_CmdBuffers.size());
+    VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, m_CmdBuffers.data()));
+
+    Recreate(width, height, vsync);
+}
+
+/**
+* Render pass of the swapchain color image and depth attachment, not used with dynamic rendering
+*/
+void Swapchain::CreateRenderPass(void) noexcept
+{
     std::array<VkAttachmentDescription, 2> attachments = {};
     // Color attachment
     attachments[0].format = m_ColorFormat;
@@ -168,16 +227,15 @@ Swapchain::Swapchain(
     renderPassInfo.pDependencies = dependencies.data();
 
     VK_CHK(vkCreateRenderPass(m_Device, &renderPassInfo, nullptr, &m_RenderPass));
-
-    VkCommandPoolCreateInfo cmdPoolInfo = vks::inits::commandPoolCreateInfo(VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-    cmdPoolInfo.queueFamilyIndex = m_QueueIndex;
-    VK_CHK(vkCreateCommandPool(device, &cmdPoolInfo, nullptr, &m_CmdPool));
-
-    Recreate(width, height, vsync);
 }
 
 Swapchain::~Swapchain(void) noexcept
 {
+    for (auto& retired : m_Retired)
+    {
+        DestroyRetired(retired);
+    }
+
     delete m_pDepthStencil;
 
     vkDestroyRenderPass(m_Device, m_RenderPass, nullptr);
@@ -185,10 +243,19 @@ Swapchain::~Swapchain(void) noexcept
     for (uint32_t i = 0; i < m_Images.size(); i++)
     {
         vkDestroyImageView(m_Device, m_Views[i], nullptr);
+    }
+    for (auto framebuffer : m_Framebuffers)
+    {
+        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+    }
+    for (auto semaphore : m_RenderDoneSemaphore)
+    {
+        vkDestroySemaphore(m_Device, semaphore, nullptr);
+    }
+    for (uint32_t i = 0; i < m_MaxFramesInFlight; i++)
+    {
         vkDestroySemaphore(m_Device, m_PresentDoneSemaphore[i], nullptr);
-        vkDestroySemaphore(m_Device, m_RenderDoneSemaphore[i], nullptr);
         vkDestroyFence(m_Device, m_WaitFences[i], nullptr);
-        vkDestroyFramebuffer(m_Device, m_Framebuffers[i], nullptr);
     }
 
     vkFreeCommandBuffers(m_Device, m_CmdPool, (uint32_t)m_CmdBuffers.size(), m_CmdBuffers.data());
@@ -198,10 +265,44 @@ Swapchain::~Swapchain(void) noexcept
     vkDestroySurfaceKHR(m_Instance, m_Surface, nullptr);
 }
 
-void Swapchain::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
+void Swapchain::DestroyRetired(Retired& retired) noexcept
 {
-    m_pDepthStencil->Recreate({ width, height, 1 });
+    for (auto framebuffer : retired.Framebuffers)
+    {
+        vkDestroyFramebuffer(m_Device, framebuffer, nullptr);
+    }
+    for (auto view : retired.Views)
+    {
+        vkDestroyImageView(m_Device, view, nullptr);
+    }
+    for (auto semaphore : retired.RenderDoneSemaphores)
+    {
+        vkDestroySemaphore(m_Device, semaphore, nullptr);
+    }
+    delete retired.pDepthStencil;
+    vkDestroySwapchainKHR(m_Device, retired.Swapchain, nullptr);
+}
 
+/**
+* Destroy the retired resources no frame in flight can use anymore, oldest first
+*/
+void Swapchain::CollectRetired(void) noexcept
+{
+    while (!m_Retired.empty() && (m_Retired.front().Frame <= m_CompletedFrame))
+    {
+        DestroyRetired(m_Retired.front());
+        m_Retired.pop_front();
+    }
+}
+
+/**
+* Create a swapchain for the current surface size, replacing the previous one
+* Does not wait for the device, the previous swapchain is passed as oldSwapchain and it, its views,
+* framebuffers, depth attachment and render semaphores are destroyed by a later AcquireNextImage once
+* every frame acquired before the call has finished
+*/
+void Swapchain::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
+{
     VkSurfaceCapabilitiesKHR surfCaps;
     VK_CHK(vkGetPhysicalDeviceSurfaceCapabilitiesKHR(m_Device.GetPhysicalDevice(), m_Surface, &surfCaps));
 
@@ -313,25 +414,38 @@ void Swapchain::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
     }
 
     VK_CHK(vkCreateSwapchainKHR(m_Device, &swapchainCI, nullptr, &m_Handle));
+    m_Extent = swapchainExtent;
 
-    // If an existing swap chain is re-created, destroy the old swap chain
-    // This also cleans up all the presentable images
-    /* cleanup for the old swapchain */
+    /* the old swapchain and everything built on its images may still be used by frames in flight */
     if (swapchainCI.oldSwapchain != VK_NULL_HANDLE)
     {
-        for (uint32_t i = 0; i < m_Images.size(); i++)
-        {
-            vkDestroyImageView(m_Device, m_Views[i], nullptr);
-        }
-        vkDestroySwapchainKHR(m_Device, swapchainCI.oldSwapchain, nullptr);
+        Retired retired{};
+        retired.Frame = m_FrameNumber;
+        retired.Swapchain = swapchainCI.oldSwapchain;
+        retired.Views = std::move(m_Views);
+        retired.Framebuffers = std::move(m_Framebuffers);
+        retired.RenderDoneSemaphores = std::move(m_RenderDoneSemaphore);
+        retired.pDepthStencil = m_pDepthStencil;
+        m_Retired.push_back(std::move(retired));
+        m_Views.clear();
+        m_Framebuffers.clear();
+        m_RenderDoneSemaphore.clear();
+
+        VkImageCreateInfo imageCI = m_pDepthStencil->GetImageCreateInfo();
+        imageCI.extent = { width, height, 1 };
+        VkImageViewCreateInfo imageViewCI = m_pDepthStencil->GetImageViewCreateInfo();
+        m_pDepthStencil = new vks::FramebufferAttachment(m_Device, imageCI, imageViewCI, m_pDepthStencil->GetUsage());
+    }
+    else
+    {
+        /* nothing has been rendered yet */
+        m_pDepthStencil->Recreate({ width, height, 1 });
     }
 
     uint32_t imageCnt;
     VK_CHK(vkGetSwapchainImagesKHR(m_Device, m_Handle, &imageCnt, nullptr));
     spdlog::debug("Swapchain image count: {}", imageCnt);
 
-    m_CurrentFrame = 0;
-
     m_Images.resize(imageCnt);
     VK_CHK(vkGetSwapchainImagesKHR(m_Device, m_Handle, &imageCnt, m_Images.data()));
 
@@ -361,16 +475,17 @@ void Swapchain::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
         VK_CHK(vkCreateImageView(m_Device, &colorAttachmentView, nullptr, &m_Views[i]));
     }
 
-    m_PresentDoneSemaphore.resize(imageCnt);
+    /* fresh semaphores, a pending present of the old swapchain may still wait on the retired ones */
     m_RenderDoneSemaphore.resize(imageCnt);
-    m_WaitFences.resize(imageCnt);
-
     VkSemaphoreCreateInfo semaphoreCreateInfo = vks::inits::semaphoreCreateInfo();
-    VkFenceCreateInfo fenceCreateInfo = vks::inits::fenceCreateInfo(VK_FENCE_CREATE_SIGNALED_BIT);
     for (size_t i = 0; i < imageCnt; i++) {
-        VK_CHK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_PresentDoneSemaphore[i]));
         VK_CHK(vkCreateSemaphore(m_Device, &semaphoreCreateInfo, nullptr, &m_RenderDoneSemaphore[i]));
-        VK_CHK(vkCreateFence(m_Device, &fenceCreateInfo, nullptr, &m_WaitFences[i]));
+    }
+
+    /* dynamic rendering takes the views directly */
+    if (m_DynamicRendering)
+    {
+        return;
     }
 
     VkImageView attachments[2];
@@ -388,60 +503,189 @@ void Swapchain::Recreate(uint32_t& width, uint32_t& height, bool vsync) noexcept
         attachments[0] = m_Views[i];
         VK_CHK(vkCreateFramebuffer(m_Device, &framebufferInfo, nullptr, &m_Framebuffers[i]));
     }
-
-    /* Vulkan specifies bufferCount must be greater than 0, which is not the case for first initialization */
-    if (0 != m_CmdBuffers.size()) {
-        vkFreeCommandBuffers(m_Device, m_CmdPool, (uint32_t)m_CmdBuffers.size(), m_CmdBuffers.data());
-    }
-
-    m_CmdBuffers.resize(imageCnt);
-    VkCommandBufferAllocateInfo cmdBufAllocateInfo =
-        vks::inits::commandBufferAllocateInfo(m_CmdPool, VK_COMMAND_BUFFER_LEVEL_PRIMARY, (uint32_t)m_CmdBuffers.size());
-    VK_CHK(vkAllocateCommandBuffers(m_Device, &cmdBufAllocateInfo, m_CmdBuffers.data()));
 }
 
+/**
+* Advance to the next frame slot, wait until its previous submit has finished and acquire an image
+* At most GetMaxFramesInFlight frames are queued however many images the presentation engine hands out
+*/
 VkResult Swapchain::AcquireNextImage(void) noexcept
 {
-    m_CurrentFrame = (m_CurrentFrame + 1) % GetImageCount();
+    m_CurrentFrame = (m_CurrentFrame + 1) % m_MaxFramesInFlight;
     //spdlog::trace("Acquiring in-flight frame: {}", m_CurrentFrame);
 
     vkWaitForFences(m_Device, 1, &m_WaitFences[m_CurrentFrame], VK_TRUE, UINT64_MAX);
-    vkResetFences(m_Device, 1, &m_WaitFences[m_CurrentFrame]);
+    /* submits complete in order on the queue, so every frame up to this fence's has finished */
+    m_CompletedFrame = std::max(m_CompletedFrame, m_FenceFrames[m_CurrentFrame]);
+    CollectRetired();
 
     VkResult result =
         vkAcquireNextImageKHR(m_Device, m_Handle, UINT64_MAX, m_PresentDoneSemaphore[m_CurrentFrame], (VkFence)VK_NULL_HANDLE, &m_ImageIndex);
+    /* the fence outlives Recreate, so it stays signaled when no submit follows a failed acquire */
+    if ((VK_SUCCESS == result) || (VK_SUBOPTIMAL_KHR == result))
+    {
+        vkResetFences(m_Device, 1, &m_WaitFences[m_CurrentFrame]);
+        m_FenceFrames[m_CurrentFrame] = ++m_FrameNumber;
+    }
     return result;
 }
 
-VkResult Swapchain::QueueSubmit(VkQueue queue) const noexcept
+/**
+* Submit the command buffer of the current frame
+*
+* @param extraWaitSemaphores semaphores waited on besides image acquisition, e.g. from StagingUploader::RecordAcquire
+* @param extraWaitStages stage masks of the extra semaphores
+*/
+VkResult Swapchain::QueueSubmit(
+    VkQueue queue,
+    std::vector<VkSemaphore> const& extraWaitSemaphores,
+    std::vector<VkPipelineStageFlags> const& extraWaitStages
+) const noexcept
 {
+    assert(extraWaitSemaphores.size() == extraWaitStages.size());
     VkSubmitInfo submitInfo = vks::inits::submitInfo();
-    VkSemaphore waitSemaphores[] = { m_PresentDoneSemaphore[m_CurrentFrame] };
-    VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    std::vector<VkSemaphore> waitSemaphores = { m_PresentDoneSemaphore[m_CurrentFrame] };
+    std::vector<VkPipelineStageFlags> waitStages = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+    waitSemaphores.insert(waitSemaphores.end(), extraWaitSemaphores.begin(), extraWaitSemaphores.end());
+    waitStages.insert(waitStages.end(), extraWaitStages.begin(), extraWaitStages.end());
+    submitInfo.waitSemaphoreCount = (uint32_t)waitSemaphores.size();
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
     submitInfo.pCommandBuffers = &m_CmdBuffers[m_CurrentFrame];
-    VkSemaphore signalSemaphores[] = { m_RenderDoneSemaphore[m_CurrentFrame]};
+    VkSemaphore signalSemaphores[] = { m_RenderDoneSemaphore[m_ImageIndex]};
     submitInfo.signalSemaphoreCount = 1;
     submitInfo.pSignalSemaphores = signalSemaphores;
     //spdlog::trace("Queue submit wait-fence status: {}", vks::utils::statusString(vkGetFenceStatus(m_Device, m_WaitFences[m_CurrentFrame])));
     return vkQueueSubmit(queue, 1, &submitInfo, m_WaitFences[m_CurrentFrame]);
 }
 
-VkResult Swapchain::QueuePresent(VkQueue queue) const noexcept
+/**
+* Present the image of the current frame
+*
+* @param presentId id of the present for vkWaitForPresentKHR, 0 to leave it untagged, nonzero needs
+* VK_KHR_present_id enabled on the device
+*/
+VkResult Swapchain::QueuePresent(VkQueue queue, uint64_t presentId) const noexcept
 {
+    VkPresentIdKHR presentIdInfo{};
+    presentIdInfo.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+    presentIdInfo.swapchainCount = 1;
+    presentIdInfo.pPresentIds = &presentId;
+
     VkPresentInfoKHR presentInfo = {};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    presentInfo.pNext = (0 != presentId) ? &presentIdInfo : nullptr;
     presentInfo.swapchainCount = 1;
     presentInfo.pSwapchains = &m_Handle;
     presentInfo.pImageIndices = &m_ImageIndex;
-    presentInfo.pWaitSemaphores = &m_RenderDoneSemaphore[m_CurrentFrame];
+    presentInfo.pWaitSemaphores = &m_RenderDoneSemaphore[m_ImageIndex];
     presentInfo.waitSemaphoreCount = 1;
     return vkQueuePresentKHR(queue, &presentInfo);
 }
 
+/**
+* Fence signaled by the submit of the current frame, reset by a successful AcquireNextImage
+*/
+VkFence const& Swapchain::GetFence(void) const noexcept
+{
+    return m_WaitFences[m_CurrentFrame];
+}
+
+/**
+* Transition the acquired image and the depth attachment and begin dynamic rendering to them
+* Only with dynamic rendering, the counterpart of vkCmdBeginRenderPass with GetRenderPass and GetFramebuffer
+*/
+void Swapchain::BeginRendering(
+    VkCommandBuffer cmdBuffer,
+    VkClearColorValue clearColor,
+    VkClearDepthStencilValue clearDepthStencil
+) const noexcept
+{
+    assert(m_DynamicRendering);
+    VkImageAspectFlags depthAspect = m_pDepthStencil->GetImageViewCreateInfo().subresourceRange.aspectMask;
+
+    /* contents are cleared, so both start from UNDEFINED, the color write waits for the acquire semaphore stage */
+    std::array<VkImageMemoryBarrier, 2> barriers = { vks::inits::imageMemoryBarrier(), vks::inits::imageMemoryBarrier() };
+    barriers[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barriers[0].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[0].newLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barriers[0].image = m_Images[m_ImageIndex];
+    barriers[0].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    barriers[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barriers[1].newLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+    barriers[1].image = m_pDepthStencil->GetImage();
+    barriers[1].subresourceRange = { depthAspect, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmdBuffer,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+        0, 0, nullptr, 0, nullptr, (uint32_t)barriers.size(), barriers.data());
+
+    VkClearValue colorClear{};
+    colorClear.color = clearColor;
+    VkClearValue depthClear{};
+    depthClear.depthStencil = clearDepthStencil;
+    VkRenderingAttachmentInfoKHR colorAttachment = vks::inits::renderingAttachmentInfo(
+        m_Views[m_ImageIndex], VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_STORE, colorClear);
+    VkRenderingAttachmentInfoKHR depthAttachment = m_pDepthStencil->GetRenderingAttachmentInfo(
+        VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_ATTACHMENT_LOAD_OP_CLEAR, VK_ATTACHMENT_STORE_OP_DONT_CARE, depthClear);
+
+    VkRenderingInfoKHR renderingInfo = vks::inits::renderingInfo();
+    renderingInfo.renderArea = { { 0, 0 }, m_Extent };
+    renderingInfo.layerCount = 1;
+    renderingInfo.colorAttachmentCount = 1;
+    renderingInfo.pColorAttachments = &colorAttachment;
+    renderingInfo.pDepthAttachment = &depthAttachment;
+    renderingInfo.pStencilAttachment = (depthAspect & VK_IMAGE_ASPECT_STENCIL_BIT) ? &depthAttachment : nullptr;
+    vkCmdBeginRenderingKHR(cmdBuffer, &renderingInfo);
+}
+
+/**
+* End dynamic rendering and transition the acquired image for presentation
+*/
+void Swapchain::EndRendering(VkCommandBuffer cmdBuffer) const noexcept
+{
+    assert(m_DynamicRendering);
+    vkCmdEndRenderingKHR(cmdBuffer);
+
+    VkImageMemoryBarrier barrier = vks::inits::imageMemoryBarrier();
+    barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    barrier.dstAccessMask = 0;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    barrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    barrier.image = m_Images[m_ImageIndex];
+    barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    vkCmdPipelineBarrier(cmdBuffer, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+        0, 0, nullptr, 0, nullptr, 1, &barrier);
+}
+
+/**
+* Attachment formats to chain into VkGraphicsPipelineCreateInfo::pNext with renderPass left VK_NULL_HANDLE
+* The returned struct points into the swapchain and stays valid as long as it
+*/
+VkPipelineRenderingCreateInfoKHR Swapchain::GetPipelineRenderingCreateInfo(void) const noexcept
+{
+    VkFormat depthFormat = m_pDepthStencil->GetFormat();
+    bool stencil = m_pDepthStencil->GetImageViewCreateInfo().subresourceRange.aspectMask & VK_IMAGE_ASPECT_STENCIL_BIT;
+
+    VkPipelineRenderingCreateInfoKHR renderingCI = vks::inits::pipelineRenderingCreateInfo();
+    renderingCI.colorAttachmentCount = 1;
+    renderingCI.pColorAttachmentFormats = &m_ColorFormat;
+    renderingCI.depthAttachmentFormat = depthFormat;
+    renderingCI.stencilAttachmentFormat = stencil ? depthFormat : VK_FORMAT_UNDEFINED;
+    return renderingCI;
+}
+
+bool Swapchain::IsDynamicRendering(void) const noexcept
+{
+    return m_DynamicRendering;
+}
+
+/**
+* Render pass compatible with the framebuffers, VK_NULL_HANDLE with dynamic rendering
+*/
 VkRenderPass const& Swapchain::GetRenderPass(void) const noexcept
 {
     return m_RenderPass;
@@ -452,11 +696,27 @@ uint32_t const& Swapchain::GetQueueIndex(void) const noexcept
     return m_QueueIndex;
 }
 
+/**
+* Frame slot in [0, GetMaxFramesInFlight), indexes per-frame resources such as FrameArena or ParallelRecorder frames
+*/
 uint32_t const& Swapchain::GetCurrentFrame(void) const noexcept
 {
     return m_CurrentFrame;
 }
 
+/**
+* Swapchain image acquired by the last AcquireNextImage, indexes per-image resources
+*/
+uint32_t const& Swapchain::GetImageIndex(void) const noexcept
+{
+    return m_ImageIndex;
+}
+
+uint32_t Swapchain::GetMaxFramesInFlight(void) const noexcept
+{
+    return m_MaxFramesInFlight;
+}
+
 size_t Swapchain::GetImageCount(void) const noexcept
 {
     return m_Images.size();
@@ -466,6 +726,11 @@ VkFormat const& Swapchain::GetColorFormat(void) const noexcept
     return m_ColorFormat;
 }
 
+VkExtent2D const& Swapchain::GetExtent(void) const noexcept
+{
+    return m_Extent;
+}
+
 std::vector<VkImageView> const& Swapchain::GetImageViews(void) const noexcept
 {
     return m_Views;
@@ -478,6 +743,7 @@ VkCommandBuffer const& Swapchain::GetCommandBuffer(void) const noexcept
 
 VkFramebuffer const& Swapchain::GetFramebuffer(void) const noexcept
 {
+    assert(!m_DynamicRendering);
     return m_Framebuffers[m_ImageIndex];
 }
 }
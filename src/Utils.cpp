@@ -80,29 +80,53 @@ void exitFatal(const std::string& message, VkResult resultCode)
     exitFatal(message, static_cast<int32_t>(resultCode));
 }
 
-VkShaderModule loadShader(const char* fileName, VkDevice device)
+/**
+* Read a SPIR-V file, e.g. to reflect it with vks::ShaderReflection before creating its module
+*
+* @return the code words, empty if the file could not be opened
+*/
+std::vector<uint32_t> loadShaderCode(const char* fileName)
 {
-    std::ifstream ifs(fileName, std::ios::binary);
+    std::ifstream ifs(fileName, std::ios::binary | std::ios::ate);
 
     if (!ifs.is_open())
     {
         spdlog::error("Could not open shader file \"{}\"", fileName);
         ifs.close();
-        return VK_NULL_HANDLE;
+        return {};
     }
 
-    std::vector<uint8_t> shaderCode((std::istreambuf_iterator<char>(ifs)), (std::istreambuf_iterator<char>()));
+    /* read in one go into word aligned storage, vks::ShaderCache also shares modules between loads */
+    size_t codeSize = (size_t)ifs.tellg();
+    std::vector<uint32_t> shaderCode(codeSize / sizeof(uint32_t));
+    ifs.seekg(0);
+    ifs.read(reinterpret_cast<char*>(shaderCode.data()), (std::streamsize)(shaderCode.size() * sizeof(uint32_t)));
     ifs.close();
 
+    return shaderCode;
+}
+
+VkShaderModule loadShader(std::vector<uint32_t> const& code, VkDevice device)
+{
     VkShaderModule shaderModule;
     VkShaderModuleCreateInfo moduleCreateInfo{};
     moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    moduleCreateInfo.codeSize = shaderCode.size();
-    moduleCreateInfo.pCode = (uint32_t*)shaderCode.data();
+    moduleCreateInfo.codeSize = code.size() * sizeof(uint32_t);
+    moduleCreateInfo.pCode = code.data();
 
     VK_CHK(vkCreateShaderModule(device, &moduleCreateInfo, NULL, &shaderModule));
 
     return shaderModule;
 }
+
+VkShaderModule loadShader(const char* fileName, VkDevice device)
+{
+    std::vector<uint32_t> shaderCode = loadShaderCode(fileName);
+    if (shaderCode.empty())
+    {
+        return VK_NULL_HANDLE;
+    }
+    return loadShader(shaderCode, device);
+}
 }
 }